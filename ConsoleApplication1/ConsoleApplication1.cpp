@@ -4,10 +4,12 @@
 #include "stdafx.h"
 
 #include <java.hpp>
+#include "benchmark.h"
 #include <iostream>
 #include <functional>
+#include <cstring>
 
-int main()
+int main(int argc, char* argv[])
 {
 	try
 	{
@@ -19,6 +21,12 @@ int main()
 		args.ignore_unrecognized(false);
 		java::vm jvm(args);
 
+		if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+		{
+			run_benchmarks();
+			return 0;
+		}
+
 		try
 		{	
 			java::clazz comparableIface("java/lang/Comparable");
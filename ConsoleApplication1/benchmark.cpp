@@ -0,0 +1,240 @@
+// benchmark.cpp : Microbenchmarks for the hot paths of the library.
+//
+
+#include "stdafx.h"
+#include "benchmark.h"
+
+#include <java.h>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Runs the function, which performs the given number of operations, 
+	// and prints the average time of one operation.
+	template <typename F>
+	void measure(const char* name, size_t iterations, F f)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		f();
+		auto elapsed = std::chrono::high_resolution_clock::now() - start;
+
+		double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+		std::cout << "  " << name << ": " << ns / iterations << " ns/op" << std::endl;
+	}
+
+	// get_env() reads a thread_local, where it used to call TlsGetValue (or
+	// pthread_getspecific).  A slot of our own stands in for the old path.
+	void bench_get_env()
+	{
+		const size_t n = 10000000;
+		JNIEnv* volatile sink = nullptr;
+		auto context = &java::internal::get_thread_context();
+
+		std::cout << "get_env" << std::endl;
+		measure("get_env (thread_local)", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) sink = java::internal::get_env();
+		});
+
+#ifdef _WIN32
+		DWORD slot = ::TlsAlloc();
+		::TlsSetValue(slot, context);
+		measure("TlsGetValue (before)", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) sink = reinterpret_cast<java::internal::thread_context*>(::TlsGetValue(slot))->env;
+		});
+		::TlsFree(slot);
+#else
+		pthread_key_t key;
+		::pthread_key_create(&key, nullptr);
+		::pthread_setspecific(key, context);
+		measure("pthread_getspecific (before)", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) sink = reinterpret_cast<java::internal::thread_context*>(::pthread_getspecific(key))->env;
+		});
+		::pthread_key_delete(key);
+#endif
+
+		JavaVM* jvm = context->vm->jvm;
+		measure("JavaVM::GetEnv", n, [&]
+		{
+			JNIEnv* env;
+			for (size_t i = 0; i < n; i++)
+			{
+				jvm->GetEnv((void**)&env, JNI_VERSION_1_6);
+				sink = env;
+			}
+		});
+	}
+
+	// Encodes n characters as UTF-8.  Every character whose index is a 
+	// multiple of every (none, if it is zero) is taken from the range 
+	// [first, first + range); the rest are ASCII letters.
+	std::string make_text(size_t n, unsigned first, unsigned range, size_t every)
+	{
+		std::string text;
+		for (size_t i = 0; i < n; i++)
+		{
+			unsigned cp = every != 0 && i % every == 0 ? first + (unsigned)(i % range) : 'a' + (unsigned)(i % 26);
+			if (cp < 0x80)
+			{
+				text += (char)cp;
+			}
+			else if (cp < 0x800)
+			{
+				text += (char)(0xC0 | (cp >> 6));
+				text += (char)(0x80 | (cp & 0x3F));
+			}
+			else
+			{
+				text += (char)(0xE0 | (cp >> 12));
+				text += (char)(0x80 | ((cp >> 6) & 0x3F));
+				text += (char)(0x80 | (cp & 0x3F));
+			}
+		}
+		return text;
+	}
+
+	// Converting strings through the library's UTF-8 transcoder, against
+	// the JVM's own modified UTF-8 functions (which agree with UTF-8 for 
+	// these texts, as none has NUL or supplementary characters).
+	void bench_utf(const char* name, const std::string& text)
+	{
+		const size_t n = 100000;
+		auto env = java::internal::get_env();
+		volatile size_t sink = 0;
+
+		std::cout << "utf: " << name << " (" << text.size() << " bytes)" << std::endl;
+		measure("jni::new_string_utf8", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) env->DeleteLocalRef(java::jni::new_string_utf8(text.data(), text.size()));
+		});
+
+		measure("NewStringUTF", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) env->DeleteLocalRef(env->NewStringUTF(text.c_str()));
+		});
+
+		jstring jstr = java::jni::new_string_utf8(text.data(), text.size());
+		measure("jni::jstring_str", n, [&]
+		{
+			for (size_t i = 0; i < n; i++) sink = java::jni::jstring_str(jstr).size();
+		});
+
+		measure("GetStringUTFChars", n, [&]
+		{
+			for (size_t i = 0; i < n; i++)
+			{
+				auto chars = env->GetStringUTFChars(jstr, nullptr);
+				sink = std::string(chars).size();
+				env->ReleaseStringUTFChars(jstr, chars);
+			}
+		});
+		env->DeleteLocalRef(jstr);
+	}
+
+	// A tight loop of field reads, and one of single-element array reads, 
+	// under one of the jni error policies.  unchecked only differs from 
+	// checked in release builds.
+	template <typename policy>
+	void bench_policy(const char* name, jobject obj, jfieldID id, jintArray arr, jsize len)
+	{
+		const size_t n = 10000000;
+		volatile jint sink = 0;
+
+		std::cout << "policy: " << name << std::endl;
+		{
+			java::deferred_scope scope;
+			measure("get_field<jint>", n, [&]
+			{
+				jint sum = 0;
+				for (size_t i = 0; i < n; i++) sum += java::jni::get_field<jint, policy>(obj, id);
+				sink = sum;
+			});
+
+			measure("get_array_region<jint>", n, [&]
+			{
+				jint sum = 0;
+				for (size_t i = 0; i < n; i++)
+				{
+					jint value;
+					java::jni::get_array_region<jint, policy>(arr, (jsize)(i % len), 1, &value);
+					sum += value;
+				}
+				sink = sum;
+			});
+		}
+	}
+
+	void bench_policies()
+	{
+		java::object point = java::create("java/awt/Point");
+		java::clazz point_class("java/awt/Point");
+		jfieldID x = java::jni::get_field_id(point_class.native(), "x", "I");
+
+		java::object values = java::to_java(std::vector<jint>(1024, 1));
+		auto arr = (jintArray)values.native();
+
+		bench_policy<java::jni::checked>("checked", point.native(), x, arr, 1024);
+		bench_policy<java::jni::deferred>("deferred", point.native(), x, arr, 1024);
+		bench_policy<java::jni::unchecked>("unchecked", point.native(), x, arr, 1024);
+	}
+
+	// Calls Comparator.compare on an implementation n times.  Each call 
+	// goes from C++ into Java and back into the handler, so the difference
+	// between implementations is the cost of the callback path.
+	void call_compare(const char* name, const java::object& comparator, jobject a, jobject b)
+	{
+		const size_t n = 1000000;
+		auto env = java::internal::get_env();
+		jmethodID compare = java::jni::get_method_id(java::clazz("java/util/Comparator").native(), "compare", "(Ljava/lang/Object;Ljava/lang/Object;)I");
+		volatile jint sink = 0;
+
+		measure(name, n, [&]
+		{
+			for (size_t i = 0; i < n; i++) sink = env->CallIntMethod(comparator.native(), compare, a, b);
+		});
+	}
+
+	// Java calling C++ through a reflection proxy, whose arguments and 
+	// result are boxed, against a native_implementation, whose generated
+	// methods call the handler directly.
+	void bench_callbacks()
+	{
+		java::object a("a");
+		java::object b("b");
+		java::clazz comparator("java/util/Comparator");
+
+		std::cout << "callbacks: Comparator.compare" << std::endl;
+
+		auto by_function = java::create_proxy(comparator, [](java::method, java::object) -> java::object { return 0; });
+		call_compare("create_proxy (handler)", by_function, a.native(), b.native());
+
+		java::proxy_method_map methods;
+		methods["compare(Ljava/lang/Object;Ljava/lang/Object;)I"] = 
+			java::proxy_method<jint(java::object, java::object)>([](java::object, java::object) -> jint { return 0; });
+		auto by_table = java::create_proxy(comparator, methods);
+		call_compare("create_proxy (proxy_method)", by_table, a.native(), b.native());
+
+		java::native_implementation impl("java/util/Comparator");
+		impl.method<jint(java::object, java::object)>("compare", [](java::object, java::object) -> jint { return 0; });
+		auto native = impl.create();
+		call_compare("native_implementation", native, a.native(), b.native());
+	}
+}
+
+void run_benchmarks()
+{
+	bench_get_env();
+
+	bench_utf("ASCII", make_text(1000, 0, 0, 0));
+	bench_utf("Latin-1", make_text(1000, 0xC0, 0x40, 6));
+	bench_utf("CJK", make_text(1000, 0x4E00, 0x5000, 1));
+
+	bench_policies();
+
+	bench_callbacks();
+}
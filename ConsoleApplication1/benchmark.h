@@ -0,0 +1,7 @@
+#pragma once
+
+// Microbenchmarks for the library's hot paths, run with "--bench".  Each 
+// one prints the time per operation of the library's path next to the 
+// path it replaced (or the JVM's own function), so that changes can be 
+// compared on the same machine.  The JVM must be created beforehand.
+void run_benchmarks();
@@ -3,9 +3,30 @@
 #include <jni.h>
 
 #include "java\type_traits.h"
+#include "java\signature.h"
+#include "java\utf.h"
+#include "java\class_writer.h"
+#include "java\method_cache.h"
+#include "java\member_cache.h"
+#include "java\class_registry.h"
+#include "java\boxing.h"
+#include "java\method_table.h"
+#include "java\string_cache.h"
+#include "java\exception_registry.h"
 #include "java\jvm.h"
 #include "java\clazz.h"
 #include "java\method.h"
 #include "java\object.h"
+#include "java\array_view.h"
+#include "java\string_view.h"
+#include "java\direct_buffer.h"
+#include "java\local_frame.h"
+#include "java\deferred_scope.h"
+#include "java\thread_context.h"
+#include "java\executor.h"
 #include "java\exception.h"
+#include "java\result.h"
+#include "java\field_handle.h"
+#include "java\typed_call.h"
 #include "java\interface_proxy.h"
+#include "java\native_implementation.h"
@@ -1,9 +1,26 @@
 #pragma once
 
 #include "java\type_traits.hpp"
+#include "java\utf.hpp"
+#include "java\class_writer.hpp"
 #include "java\jvm.hpp"
+#include "java\method_cache.hpp"
+#include "java\member_cache.hpp"
+#include "java\class_registry.hpp"
+#include "java\boxing.hpp"
+#include "java\method_table.hpp"
+#include "java\string_cache.hpp"
+#include "java\exception_registry.hpp"
 #include "java\clazz.hpp"
 #include "java\method.hpp"
 #include "java\object.hpp"
+#include "java\string_view.hpp"
+#include "java\direct_buffer.hpp"
+#include "java\local_frame.hpp"
+#include "java\deferred_scope.hpp"
+#include "java\thread_context.hpp"
+#include "java\executor.hpp"
 #include "java\exception.hpp"
-#include "java\interface_proxy.hpp"
\ No newline at end of file
+#include "java\result.hpp"
+#include "java\interface_proxy.hpp"
+#include "java\native_implementation.hpp"
\ No newline at end of file
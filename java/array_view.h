@@ -0,0 +1,159 @@
+#pragma once
+
+#include "java\object.h"
+#include <iterator>
+#include <utility>
+
+namespace java
+{
+    // Controls what happens to changes made through an array view when it
+    // is released.  array_commit copies the elements back into the Java
+    // array (if the JVM gave the view a copy), and array_abort discards
+    // them, which is cheaper for read-only access.
+    enum array_release_mode
+    {
+        array_commit = 0,
+        array_abort = JNI_ABORT
+    };
+
+    namespace internal
+    {
+        // Contiguous access to the elements of a pinned or copied Java
+        // primitive array.  The derived classes decide how the elements are
+        // acquired and released.
+        template <typename jtype>
+        class basic_array_view
+        {
+        protected:
+            typedef typename jni::type_traits<jtype>::array_type array_type;
+
+            array_type _array;
+            jtype* _data;
+            jsize _size;
+            jint _mode;
+            jboolean _is_copy;
+
+            basic_array_view(const object& arr, array_release_mode mode)
+                : _array(static_cast<array_type>(arr.native())), _data(nullptr), _size(0), _mode(mode), _is_copy(JNI_FALSE)
+            {
+                if (!arr.is_ref() || arr.is_null()) throw std::exception("Not an array reference");
+                _size = jni::get_array_length(_array);
+            }
+
+            basic_array_view(basic_array_view&& other)
+                : _array(other._array), _data(other._data), _size(other._size), _mode(other._mode), _is_copy(other._is_copy)
+            {
+                other._data = nullptr;
+            }
+
+        private:
+            basic_array_view(const basic_array_view&);
+            basic_array_view& operator= (const basic_array_view&);
+
+        public:
+            typedef jtype value_type;
+            typedef jtype& reference;
+            typedef const jtype& const_reference;
+            typedef jtype* iterator;
+            typedef const jtype* const_iterator;
+            typedef std::reverse_iterator<iterator> reverse_iterator;
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+            typedef jsize size_type;
+
+            jtype* data() { return _data; }
+            const jtype* data() const { return _data; }
+
+            jsize size() const { return _size; }
+            bool empty() const { return _size == 0; }
+
+            // Returns true if the JVM copied the elements rather than
+            // pinning the Java array.  Changes to a copy only reach the Java
+            // array when the view is released in array_commit mode.
+            bool is_copy() const { return _is_copy == JNI_TRUE; }
+
+            // Changes what happens to modified elements when the view is
+            // released.
+            void release_mode(array_release_mode mode) { _mode = mode; }
+            array_release_mode release_mode() const { return (array_release_mode)_mode; }
+
+            jtype& operator[] (jsize i) { return _data[i]; }
+            const jtype& operator[] (jsize i) const { return _data[i]; }
+
+            iterator begin() { return _data; }
+            iterator end() { return _data + _size; }
+            const_iterator begin() const { return _data; }
+            const_iterator end() const { return _data + _size; }
+            const_iterator cbegin() const { return _data; }
+            const_iterator cend() const { return _data + _size; }
+            reverse_iterator rbegin() { return reverse_iterator(end()); }
+            reverse_iterator rend() { return reverse_iterator(begin()); }
+            const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+            const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        };
+    }
+
+    // This class gives C++ code direct access to the elements of a Java
+    // primitive array, through Get<Type>ArrayElements.  The elements are
+    // pinned or copied once, when the view is created, and released when
+    // the view is destroyed.  This makes it suitable for tight loops and
+    // STL algorithms, unlike object::operator[], which has to acquire and
+    // release the elements for every access.  The java::object holding the
+    // array must outlive the view, and the view can only be used on the
+    // thread that created it.
+    template <typename jtype>
+    class array_view : public internal::basic_array_view<jtype>
+    {
+        typedef internal::basic_array_view<jtype> base;
+
+    public:
+        array_view(const object& arr, array_release_mode mode = array_commit)
+            : base(arr, mode)
+        {
+            this->_data = jni::get_array_elements<jtype>(this->_array, &this->_is_copy);
+        }
+
+        array_view(array_view&& other) : base(std::move(other)) {}
+
+        ~array_view()
+        {
+            if (this->_data != nullptr)
+                jni::type_traits<jtype>::release_array_elements(internal::get_env(), this->_array, this->_data, this->_mode);
+        }
+
+        // Copies any changes back into the Java array, while keeping the
+        // view open.  This is a no-op if the array is pinned.
+        void commit()
+        {
+            if (this->_is_copy)
+                jni::release_array_elements<jtype>(this->_array, this->_data, JNI_COMMIT);
+        }
+    };
+
+    // This class is similar to array_view, but uses
+    // GetPrimitiveArrayCritical, which makes it much more likely that the
+    // JVM hands out a pointer to the array itself rather than a copy.  The
+    // price is that the JVM may suspend garbage collection while the view
+    // exists, so no other JNI functions may be called (including any other
+    // java::* functions) and the thread must not block until the view is
+    // destroyed.  Keep these short-lived.
+    template <typename jtype>
+    class critical_array_view : public internal::basic_array_view<jtype>
+    {
+        typedef internal::basic_array_view<jtype> base;
+
+    public:
+        critical_array_view(const object& arr, array_release_mode mode = array_commit)
+            : base(arr, mode)
+        {
+            this->_data = static_cast<jtype*>(jni::get_primitive_array_critical(this->_array, &this->_is_copy));
+        }
+
+        critical_array_view(critical_array_view&& other) : base(std::move(other)) {}
+
+        ~critical_array_view()
+        {
+            if (this->_data != nullptr)
+                internal::get_env()->ReleasePrimitiveArrayCritical(this->_array, this->_data, this->_mode);
+        }
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "jni.h"
+#include "java\type_traits.h"
+#include <atomic>
+
+namespace java
+{
+    namespace internal
+    {
+        // The wrapper class of a primitive type (e.g., java.lang.Integer 
+        // for int), along with the ID's of its static valueOf method and 
+        // its xxxValue unboxing method.  The class is a global reference 
+        // owned by the class registry.
+        struct boxed_type
+        {
+            jclass cls;
+            jmethodID value_of;
+            jmethodID unbox;
+        };
+
+
+        // This class resolves the wrapper classes and their boxing and 
+        // unboxing methods once per JVM, so that boxing is a single 
+        // CallStaticObjectMethod (which also benefits from the JVM's 
+        // Integer/Long/... caches), and unboxing a single Call<Type>Method.
+        // Entries are created on first use and published atomically, so 
+        // readers never take a lock.
+        class boxing_cache
+        {
+            static const size_t primitive_count = jni::jdouble_value + 1;
+
+            std::atomic<boxed_type*> _types[primitive_count];
+            std::atomic<jclass> _primitive_classes[primitive_count];
+
+            // java.lang.Number and its xxxValue methods, indexed by the 
+            // primitive type they return.
+            std::atomic<jclass> _number_class;
+            std::atomic<jmethodID> _number_methods[primitive_count];
+
+            boxing_cache(const boxing_cache&);
+            boxing_cache& operator= (const boxing_cache&);
+
+        public:
+            boxing_cache();
+            ~boxing_cache();
+
+            // Returns the wrapper class and methods for a primitive type.
+            const boxed_type& get(jni::value_type kind);
+
+            // Returns the class of a primitive type (e.g., int.class), which
+            // is used to match primitive arguments against method 
+            // parameters.  The reference is owned by the cache.
+            jclass primitive_class(jni::value_type kind);
+
+            // Returns java.lang.Number.
+            jclass number_class();
+
+            // Returns the java.lang.Number method that converts a number to
+            // the given primitive type (intValue, doubleValue, ...).  
+            // There's no Number method for char or boolean, so an exception
+            // is thrown for those.
+            jmethodID number_method(jni::value_type kind);
+
+            // Deletes the global references to the primitive classes.
+            void clear();
+        };
+    }
+}
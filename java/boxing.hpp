@@ -0,0 +1,138 @@
+
+#include "boxing.h"
+#include "jvm.h"
+
+namespace java
+{
+    namespace internal
+    {
+        namespace
+        {
+            struct wrapper_info
+            {
+                const char* class_name;
+                const char* value_of;
+                const char* unbox_name;
+                const char* unbox;
+            };
+
+            // Indexed by jni::value_type
+            const wrapper_info wrappers[] = {
+                { "java/lang/Boolean", "(Z)Ljava/lang/Boolean;", "booleanValue", "()Z" },
+                { "java/lang/Byte", "(B)Ljava/lang/Byte;", "byteValue", "()B" },
+                { "java/lang/Character", "(C)Ljava/lang/Character;", "charValue", "()C" },
+                { "java/lang/Short", "(S)Ljava/lang/Short;", "shortValue", "()S" },
+                { "java/lang/Integer", "(I)Ljava/lang/Integer;", "intValue", "()I" },
+                { "java/lang/Long", "(J)Ljava/lang/Long;", "longValue", "()J" },
+                { "java/lang/Float", "(F)Ljava/lang/Float;", "floatValue", "()F" },
+                { "java/lang/Double", "(D)Ljava/lang/Double;", "doubleValue", "()D" },
+            };
+        }
+
+        boxing_cache::boxing_cache()
+            : _number_class(nullptr)
+        {
+            for (size_t i = 0; i < primitive_count; i++)
+            {
+                _types[i].store(nullptr, std::memory_order_relaxed);
+                _primitive_classes[i].store(nullptr, std::memory_order_relaxed);
+                _number_methods[i].store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        boxing_cache::~boxing_cache()
+        {
+            // The classes are owned by the class registry, so only the 
+            // memory is released here.
+            for (size_t i = 0; i < primitive_count; i++)
+                delete _types[i].exchange(nullptr);
+        }
+
+        const boxed_type& boxing_cache::get(jni::value_type kind)
+        {
+            if ((size_t)kind >= primitive_count) throw std::exception("Not a primitive type");
+
+            boxed_type* cached = _types[kind].load(std::memory_order_acquire);
+            if (cached != nullptr) return *cached;
+
+            auto& info = wrappers[kind];
+            boxed_type* resolved = new boxed_type();
+            try
+            {
+                resolved->cls = get_class_registry().find(info.class_name);
+                resolved->value_of = jni::get_static_method_id(resolved->cls, "valueOf", info.value_of);
+                resolved->unbox = jni::get_method_id(resolved->cls, info.unbox_name, info.unbox);
+            }
+            catch (...)
+            {
+                delete resolved;
+                throw;
+            }
+
+            // Another thread may have resolved the same type in the 
+            // meantime, in which case its entry is kept.
+            if (!_types[kind].compare_exchange_strong(cached, resolved, std::memory_order_acq_rel))
+            {
+                delete resolved;
+                return *cached;
+            }
+
+            return *resolved;
+        }
+
+        jclass boxing_cache::primitive_class(jni::value_type kind)
+        {
+            if ((size_t)kind >= primitive_count) throw std::exception("Not a primitive type");
+
+            jclass cls = _primitive_classes[kind].load(std::memory_order_acquire);
+            if (cls != nullptr) return cls;
+
+            auto& boxed = get(kind);
+            auto type = jni::get_static_field_id(boxed.cls, "TYPE", "Ljava/lang/Class;");
+            local_ref<jclass> local = jni::get_static_field<jobject>(boxed.cls, type);
+
+            jclass global = (jclass)jni::new_global_ref(local.get());
+            if (!_primitive_classes[kind].compare_exchange_strong(cls, global, std::memory_order_acq_rel))
+            {
+                jni::delete_global_ref(global);
+                return cls;
+            }
+
+            return global;
+        }
+
+        jclass boxing_cache::number_class()
+        {
+            jclass cls = _number_class.load(std::memory_order_acquire);
+            if (cls == nullptr)
+            {
+                cls = get_class_registry().find("java/lang/Number");
+                _number_class.store(cls, std::memory_order_release);
+            }
+            return cls;
+        }
+
+        jmethodID boxing_cache::number_method(jni::value_type kind)
+        {
+            if (kind == jni::jboolean_value || kind == jni::jchar_value || (size_t)kind >= primitive_count)
+                throw std::exception("Not a numeric type");
+
+            jmethodID id = _number_methods[kind].load(std::memory_order_acquire);
+            if (id == nullptr)
+            {
+                id = jni::get_method_id(number_class(), wrappers[kind].unbox_name, wrappers[kind].unbox);
+                _number_methods[kind].store(id, std::memory_order_release);
+            }
+            return id;
+        }
+
+        void boxing_cache::clear()
+        {
+            for (size_t i = 0; i < primitive_count; i++)
+            {
+                jclass cls = _primitive_classes[i].exchange(nullptr);
+                if (cls != nullptr) jni::delete_global_ref(cls);
+            }
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "jni.h"
+#include <atomic>
+#include <string>
+
+namespace java
+{
+    namespace internal
+    {
+        // This class interns class names to global jclass references, so 
+        // that each class is only looked up with FindClass (or 
+        // ClassLoader.loadClass) once per JVM.  Entries are keyed by the 
+        // JNI class name (e.g., "java/lang/String") and the class loader 
+        // the class was resolved through.  A null loader stands for the 
+        // default FindClass lookup.  The registry holds global references 
+        // to the classes and loaders, which keeps them from being unloaded
+        // while the JVM is running.
+        //
+        // Like method_cache, readers never take a lock.  Entries are 
+        // immutable once published, and are only freed by clear().
+        class class_registry
+        {
+            static const size_t bucket_count = 256;
+
+            struct entry
+            {
+                size_t hash;
+                std::string name;
+                jobject loader;
+                jclass cls;
+                entry* next;
+            };
+
+            std::atomic<entry*> _buckets[bucket_count];
+
+            static size_t hash(const char* name);
+
+            const entry* find_entry(const char* name, jobject loader);
+
+            class_registry(const class_registry&);
+            class_registry& operator= (const class_registry&);
+
+        public:
+            class_registry();
+            ~class_registry();
+
+            // Returns the global reference to the named class, resolving it
+            // on first use.  The reference is owned by the registry and 
+            // stays valid until clear() is called.  Throws an exception if 
+            // the class can't be found.
+            jclass find(const char* name, jobject loader = nullptr);
+
+            // Records a class that was created outside the registry (e.g., 
+            // by DefineClass), so that later lookups of the name through 
+            // the given loader return it.  Returns the registry's global 
+            // reference to the class.
+            jclass insert(const char* name, jobject loader, jclass cls);
+
+            // Deletes all entries and the global references they hold.
+            void clear();
+        };
+    }
+}
@@ -0,0 +1,129 @@
+
+#include "class_registry.h"
+#include "jvm.h"
+
+namespace java
+{
+    namespace internal
+    {
+        class_registry::class_registry()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+                _buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        class_registry::~class_registry()
+        {
+            // Only the memory is released here, since the JVM may already 
+            // be gone.  Call clear() beforehand to release the global 
+            // references.
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        size_t class_registry::hash(const char* name)
+        {
+            size_t h = 2166136261u;
+            for (const char* c = name; *c != '\0'; c++)
+                h = (h ^ (unsigned char)*c) * 16777619u;
+            return h;
+        }
+
+        const class_registry::entry* class_registry::find_entry(const char* name, jobject loader)
+        {
+            auto h = hash(name);
+
+            for (entry* e = _buckets[h % bucket_count].load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (e->hash != h || e->name != name)
+                    continue;
+
+                // Most lookups go through the default loader, which doesn't
+                // need a call into the JVM to compare.
+                if (e->loader == nullptr || loader == nullptr)
+                {
+                    if (e->loader == loader) return e;
+                }
+                else if (get_env()->IsSameObject(e->loader, loader))
+                {
+                    return e;
+                }
+            }
+
+            return nullptr;
+        }
+
+        jclass class_registry::find(const char* name, jobject loader)
+        {
+            auto cached = find_entry(name, loader);
+            if (cached != nullptr) return cached->cls;
+
+            local_ref<jclass> cls;
+            if (loader == nullptr)
+            {
+                cls = jni::find_class(name);
+            }
+            else
+            {
+                // ClassLoader.loadClass expects a binary name, with dots
+                // rather than slashes.
+                std::string binary_name(name);
+                for (auto it = binary_name.begin(); it != binary_name.end(); it++)
+                    if (*it == '/') *it = '.';
+
+                local_ref<jclass> loader_class = jni::get_object_class(loader);
+                auto loadClass = jni::get_method_id(loader_class.get(), "loadClass", "(Ljava/lang/String;)Ljava/lang/Class;");
+                local_ref<jstring> jname = jni::new_string_utf(binary_name.c_str());
+                cls = jni::call_method<jobject>(loader, loadClass, jname.get());
+            }
+
+            return insert(name, loader, cls.get());
+        }
+
+        jclass class_registry::insert(const char* name, jobject loader, jclass cls)
+        {
+            // Two threads may resolve the same class at the same time, in 
+            // which case both entries are published.  That's harmless, 
+            // since they refer to the same class and lookups return the 
+            // first match.
+            entry* e = new entry();
+            e->hash = hash(name);
+            e->name = name;
+            e->loader = loader == nullptr ? nullptr : jni::new_global_ref(loader);
+            e->cls = (jclass)jni::new_global_ref(cls);
+
+            auto& bucket = _buckets[e->hash % bucket_count];
+            e->next = bucket.load(std::memory_order_relaxed);
+            while (!bucket.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            return e->cls;
+        }
+
+        void class_registry::clear()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+
+                    jni::delete_global_ref(e->cls);
+                    if (e->loader != nullptr) jni::delete_global_ref(e->loader);
+
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace java
+{
+    namespace internal
+    {
+        // The access flags used by class_writer
+        enum access_flags : uint16_t
+        {
+            acc_public = 0x0001,
+            acc_private = 0x0002,
+            acc_protected = 0x0004,
+            acc_static = 0x0008,
+            acc_final = 0x0010,
+            acc_super = 0x0020,
+            acc_native = 0x0100
+        };
+
+        // The opcodes used by generated code
+        enum opcode : unsigned char
+        {
+            op_sipush = 0x11,
+            op_iload = 0x15,
+            op_lload = 0x16,
+            op_fload = 0x17,
+            op_dload = 0x18,
+            op_aload = 0x19,
+            op_lload_1 = 0x1f,
+            op_aload_0 = 0x2a,
+            op_ireturn = 0xac,
+            op_lreturn = 0xad,
+            op_freturn = 0xae,
+            op_dreturn = 0xaf,
+            op_areturn = 0xb0,
+            op_return = 0xb1,
+            op_getfield = 0xb4,
+            op_putfield = 0xb5,
+            op_invokespecial = 0xb7,
+            op_invokestatic = 0xb8
+        };
+
+        // The body of a method: the bytecode and the stack and local
+        // variable sizes it needs.  There is no support for branches,
+        // exception tables or stack map frames, which straight-line code
+        // doesn't need.
+        struct bytecode
+        {
+            std::vector<unsigned char> code;
+            uint16_t max_stack;
+            uint16_t max_locals;
+
+            bytecode() : max_stack(0), max_locals(0) {}
+
+            bytecode& op(unsigned char opcode) { code.push_back(opcode); return *this; }
+            bytecode& u1(unsigned value) { code.push_back((unsigned char)value); return *this; }
+            bytecode& u2(unsigned value) { code.push_back((unsigned char)(value >> 8)); code.push_back((unsigned char)value); return *this; }
+        };
+
+        // This class assembles a class file in memory, for classes that are
+        // generated at runtime and loaded with load_class.  Constant pool
+        // entries are shared between all uses of the same constant.
+        class class_writer
+        {
+            std::vector<unsigned char> _pool;
+            uint16_t _pool_count;
+            std::map<std::string, uint16_t> _constants;
+
+            std::vector<unsigned char> _fields;
+            uint16_t _field_count;
+
+            std::vector<unsigned char> _methods;
+            uint16_t _method_count;
+
+            uint16_t constant(unsigned char tag, const std::string& key, const std::vector<unsigned char>& data);
+
+        public:
+            class_writer() : _pool_count(1), _field_count(0), _method_count(0) {}
+
+            // These add constants to the pool (if they aren't already in
+            // it), and return their index.
+            uint16_t utf8(const std::string& value);
+            uint16_t class_ref(const std::string& name);
+            uint16_t name_and_type(const std::string& name, const std::string& descriptor);
+            uint16_t field_ref(const std::string& cls, const std::string& name, const std::string& descriptor);
+            uint16_t method_ref(const std::string& cls, const std::string& name, const std::string& descriptor);
+
+            void add_field(uint16_t access, const std::string& name, const std::string& descriptor);
+
+            // Adds a method.  Abstract and native methods have no code.
+            void add_method(uint16_t access, const std::string& name, const std::string& descriptor, const bytecode* code = nullptr);
+
+            // Returns the class file.  Major version 50 (Java 6) is used, as
+            // it is the oldest one the library supports.
+            std::vector<unsigned char> write(uint16_t access, const std::string& name, const std::string& super_name, const std::vector<std::string>& interfaces);
+        };
+    }
+}
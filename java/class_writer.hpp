@@ -0,0 +1,165 @@
+
+#include "class_writer.h"
+
+namespace java
+{
+    namespace internal
+    {
+        namespace
+        {
+            enum constant_tag : unsigned char
+            {
+                constant_utf8 = 1,
+                constant_class = 7,
+                constant_fieldref = 9,
+                constant_methodref = 10,
+                constant_name_and_type = 12
+            };
+
+            void put_u2(std::vector<unsigned char>& out, unsigned value)
+            {
+                out.push_back((unsigned char)(value >> 8));
+                out.push_back((unsigned char)value);
+            }
+
+            void put_u4(std::vector<unsigned char>& out, uint32_t value)
+            {
+                put_u2(out, value >> 16);
+                put_u2(out, value & 0xffff);
+            }
+
+            void append(std::vector<unsigned char>& out, const std::vector<unsigned char>& data)
+            {
+                out.insert(out.end(), data.begin(), data.end());
+            }
+        }
+
+        uint16_t class_writer::constant(unsigned char tag, const std::string& key, const std::vector<unsigned char>& data)
+        {
+            std::string full_key(1, (char)tag);
+            full_key += key;
+
+            auto it = _constants.find(full_key);
+            if (it != _constants.end()) return it->second;
+
+            _pool.push_back(tag);
+            append(_pool, data);
+            _constants[full_key] = _pool_count;
+            return _pool_count++;
+        }
+
+        uint16_t class_writer::utf8(const std::string& value)
+        {
+            // Generated names and descriptors are ASCII, which is the same in
+            // the class file's modified UTF-8.
+            std::vector<unsigned char> data;
+            put_u2(data, (unsigned)value.size());
+            data.insert(data.end(), value.begin(), value.end());
+            return constant(constant_utf8, value, data);
+        }
+
+        uint16_t class_writer::class_ref(const std::string& name)
+        {
+            std::vector<unsigned char> data;
+            put_u2(data, utf8(name));
+            return constant(constant_class, name, data);
+        }
+
+        uint16_t class_writer::name_and_type(const std::string& name, const std::string& descriptor)
+        {
+            std::vector<unsigned char> data;
+            put_u2(data, utf8(name));
+            put_u2(data, utf8(descriptor));
+            return constant(constant_name_and_type, name + ":" + descriptor, data);
+        }
+
+        uint16_t class_writer::field_ref(const std::string& cls, const std::string& name, const std::string& descriptor)
+        {
+            std::vector<unsigned char> data;
+            put_u2(data, class_ref(cls));
+            put_u2(data, name_and_type(name, descriptor));
+            return constant(constant_fieldref, cls + "." + name + ":" + descriptor, data);
+        }
+
+        uint16_t class_writer::method_ref(const std::string& cls, const std::string& name, const std::string& descriptor)
+        {
+            std::vector<unsigned char> data;
+            put_u2(data, class_ref(cls));
+            put_u2(data, name_and_type(name, descriptor));
+            return constant(constant_methodref, cls + "." + name + ":" + descriptor, data);
+        }
+
+        void class_writer::add_field(uint16_t access, const std::string& name, const std::string& descriptor)
+        {
+            put_u2(_fields, access);
+            put_u2(_fields, utf8(name));
+            put_u2(_fields, utf8(descriptor));
+            put_u2(_fields, 0);
+            _field_count++;
+        }
+
+        void class_writer::add_method(uint16_t access, const std::string& name, const std::string& descriptor, const bytecode* code)
+        {
+            put_u2(_methods, access);
+            put_u2(_methods, utf8(name));
+            put_u2(_methods, utf8(descriptor));
+
+            if (code == nullptr)
+            {
+                put_u2(_methods, 0);
+            }
+            else
+            {
+                // One Code attribute, with no exception table and no
+                // attributes of its own
+                put_u2(_methods, 1);
+                put_u2(_methods, utf8("Code"));
+                put_u4(_methods, (uint32_t)(12 + code->code.size()));
+                put_u2(_methods, code->max_stack);
+                put_u2(_methods, code->max_locals);
+                put_u4(_methods, (uint32_t)code->code.size());
+                append(_methods, code->code);
+                put_u2(_methods, 0);
+                put_u2(_methods, 0);
+            }
+
+            _method_count++;
+        }
+
+        std::vector<unsigned char> class_writer::write(uint16_t access, const std::string& name, const std::string& super_name, const std::vector<std::string>& interfaces)
+        {
+            // These add to the pool, so they must come before it is copied
+            uint16_t this_index = class_ref(name);
+            uint16_t super_index = class_ref(super_name);
+            std::vector<uint16_t> interface_indices;
+            for (auto it = interfaces.begin(); it != interfaces.end(); it++)
+                interface_indices.push_back(class_ref(*it));
+
+            std::vector<unsigned char> out;
+            put_u4(out, 0xcafebabe);
+            put_u2(out, 0);
+            put_u2(out, 50);
+
+            put_u2(out, _pool_count);
+            append(out, _pool);
+
+            put_u2(out, access);
+            put_u2(out, this_index);
+            put_u2(out, super_index);
+
+            put_u2(out, (unsigned)interface_indices.size());
+            for (auto it = interface_indices.begin(); it != interface_indices.end(); it++)
+                put_u2(out, *it);
+
+            put_u2(out, _field_count);
+            append(out, _fields);
+
+            put_u2(out, _method_count);
+            append(out, _methods);
+
+            // No class attributes
+            put_u2(out, 0);
+            return out;
+        }
+    }
+}
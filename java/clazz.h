@@ -9,6 +9,8 @@ namespace java
 {
     class method;
     class method_list;
+    template <typename jtype> class field_handle;
+    template <typename jtype> class static_field_handle;
 
     // Wrapper for a Java class object. "clazz" naming is to avoid conflict 
     // with C++ class keyword.
@@ -28,23 +30,55 @@ namespace java
         // "java/lang/String".  Generic types don't have any special notation,
         // e.g., java.util.ArrayList<E> is just "java/util/ArrayList".  This 
         // is because the JVM doesn't have any notion of generics- it is only 
-        // known at the compiler level.
+        // known at the compiler level.  Classes are resolved once per JVM
+        // and then served from the class registry, so the clazz holds a 
+        // global reference that is owned by the registry.
         clazz(const char* name);
 
+        // Looks up a Java class through the given java.lang.ClassLoader, 
+        // rather than the default FindClass lookup.  The result is cached 
+        // per loader.
+        clazz(const char* name, const object& loader);
+
         // Returns a clazz object that corresponds to the specified object.  
         // The object should be an instance of a java.lang.Class object.
         clazz(object);
 
 		clazz(jclass cls);
 
-        local_ref<jclass> ref() const { return _ref; }
-        jclass native() const { return reinterpret_cast<jclass>(_ref.get()); }
+        jclass native() const { return reinterpret_cast<jclass>(_value.l); }
 
         std::string name() const;
 
         // Returns a class field value with the given name.
         object static_field(const char* name);
 
+        // Reads or writes a static field of the given JNI type.  Like 
+        // object::get and object::set, the field ID is resolved once and 
+        // cached.
+        template <typename jtype>
+        typename internal::field_access<jtype>::type get_static(const char* name) const
+        {
+            auto id = internal::get_member_cache().get_field(_value.l, internal::static_field, name, jni::descriptor<jtype>::type::value);
+            return internal::field_access<jtype>::get_static(native(), id);
+        }
+
+        template <typename jtype>
+        void set_static(const char* name, typename internal::field_access<jtype>::param_type value)
+        {
+            auto id = internal::get_member_cache().get_field(_value.l, internal::static_field, name, jni::descriptor<jtype>::type::value);
+            internal::field_access<jtype>::set_static(native(), id, value);
+        }
+
+        // Resolves a field of the given JNI type once, returning a handle 
+        // that reads and writes it without any further lookup.  Throws 
+        // nosuchfield_exception if there is no such field.
+        template <typename jtype>
+        field_handle<jtype> find_field(const char* name) const;
+
+        template <typename jtype>
+        static_field_handle<jtype> find_static_field(const char* name) const;
+
         // Finds a method that is callable, given the set of classes as 
         // method arguments.  A method is considered appropriate if it has 
         // the correct name, correct number of arguments, and each class is 
@@ -60,23 +94,38 @@ namespace java
         // Returns a list of constructors for this class using reflection.
         method_list get_constructors();
 
-        // These methods call static Java methods on the class given the 
-        // method name and a number of arguments.  An exception is thrown
-        // if an appropriate method is not found.  Also, the first method 
-        // which accepts the given arguments is called, even if there is a 
-        // "better" match.  For now, if it is necessary to disambiguate, the
-        // low-level jni::call_xxx_method() functions must be used.
-        object call_static(const char* method_name);
-        object call_static(const char* method_name, object a1);
-        object call_static(const char* method_name, object a1, object a2);
-        object call_static(const char* method_name, object a1, object a2, object a3);
-        object call_static(const char* method_name, object a1, object a2, object a3, object a4);
+        // Resolves a method by name (or a constructor, for "<init>") given 
+        // the classes of the arguments, through the method cache.  A null 
+        // class matches any reference parameter.  The result is owned by 
+        // the cache and stays valid for the lifetime of the JVM.  Throws 
+        // nosuchmethod_exception if there is no appropriate method.
+        const internal::resolved_method& resolve_method(const char* name, const jclass* arg_classes, size_t num_args);
+
+        // Calls a static Java method on the class given the method name 
+        // and any number of arguments, which are marshalled the same way 
+        // as for object::call.  An exception is thrown if an appropriate 
+        // method is not found.  Also, the first method which accepts the 
+        // given arguments is called, even if there is a "better" match.  
+        // For now, if it is necessary to disambiguate, java::call_static 
+        // or the low-level jni::call_xxx_method() functions must be used.
+        template <typename... ts>
+        object call_static(const char* method_name, const ts&... args)
+        {
+            internal::arg_pack<sizeof...(ts)> pack(args...);
+            return invoke_static(method_name, pack.values, pack.classes, pack.size);
+        }
+
+        // Does the same as call_static(), but returns failures (including 
+        // any exception thrown by the Java method) instead of throwing them.
+        template <typename... ts>
+        result<object> try_call_static(const char* method_name, const ts&... args);
 
         static java::clazz clazz::from_value(java::object& arg);
         static java::clazz clazz::from_value(jint arg);
 
     private:
-        java::object call_static_method(java::method m, ...);
+        java::object invoke_static(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
+        result<object> try_invoke_static(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
 
         static jobject get_native(java::object& value);
         static jint get_native(jint value);
@@ -85,6 +134,7 @@ namespace java
     // This function can be used to load classes from raw compiled class data 
     // (e.g., content of a .class file generated by javac).  The system class 
     // loader (as returned by java.lang.ClassLoader.getSystemClassLoader()) 
-    // is used to load the data into the JVM.
+    // is used to load the data into the JVM.  The class is added to the 
+    // class registry, so that later clazz(class_name) lookups return it.
     clazz load_class(const char* class_name, jbyte* class_data, jsize size);
 }
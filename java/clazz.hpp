@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <algorithm>
+#include <cstring>
 
 namespace java
 {
@@ -11,191 +12,129 @@ namespace java
     }
 
     clazz::clazz(const char* name)
-		    : object(jni::find_class(name))
+		    : object(object::borrow(internal::get_class_registry().find(name)))
+    {
+    }
+
+    clazz::clazz(const char* name, const object& loader)
+        : object(object::borrow(internal::get_class_registry().find(name, loader.native())))
     {
     }
 
 	clazz::clazz(jclass cls) : object(cls) {}
 
-    clazz::clazz(java::object obj) : object(obj) {}
+    clazz::clazz(java::object obj) : object(std::move(obj)) {}
 
     std::string clazz::name() const
     {
-        clazz cls_cls(jni::get_object_class(_ref.get()));
+        clazz cls_cls(jni::get_object_class(_value.l));
         auto getName = jni::get_method_id(cls_cls.native(), "getName", "()Ljava/lang/String;");
-        local_ref<jstring> name = jni::call_method<jobject>(_ref.get(), getName);
+        local_ref<jstring> name = jni::call_method<jobject>(_value.l, getName);
         return jstring_str(name.get());
     }
 
     object clazz::static_field(const char* name)
     {
-        return call("getField", name).call("get", object::null());
+        return call("getField", object::intern(name)).call("get", object::null());
     }
 
-    method clazz::lookup_method(const char* name, const std::vector<clazz>& classes)
+    namespace internal
     {
-        auto methods = get_methods();
-        auto match = std::find_if(methods.begin(), methods.end(), [&](const method& m) -> bool
+        // Builds the cache entry for a method in a method table.
+        static resolved_method resolve(const method_table& table, size_t i)
         {
-            bool ret = m.name() == name && m.is_args_assignable(classes);
+            resolved_method ret;
+            ret.id = table.ids[i];
+            ret.method_obj = jni::new_global_ref(table.method_objs[i]);
+            ret.return_kind = table.return_kinds[i];
+            ret.param_kinds.assign(table.param_kinds.begin() + table.param_begin[i], table.param_kinds.begin() + table.param_begin[i + 1]);
+            ret.is_static = !table.constructors && table.is_static(i);
+            ret.table = &table;
+            ret.index = i;
             return ret;
-        });
-    
-        if (match == methods.end()) throw nosuchmethod_exception(*this, name, classes);
-        return *match;
-    }
+        }
 
-    method clazz::lookup_constructor(const std::vector<clazz>& classes)
-    {
-        auto ctors = get_constructors();
-        auto match = std::find_if(ctors.begin(), ctors.end(), [&](const method& ctor)
+        static std::vector<jclass> native_classes(const std::vector<clazz>& classes)
         {
-            return ctor.is_args_assignable(classes);
-        });
-    
-        if (match == ctors.end()) throw nosuchmethod_exception(*this, "<init>", classes);
-        return *match;
-    }
-
-    method_list clazz::get_methods()
-    {
-        // Get the java.lang.Class object associated with this class.
-        clazz cls_cls(jni::get_object_class(_ref.get()));
-
-        // Get an array of methods
-        auto getMethods = jni::get_method_id(cls_cls.native(), "getMethods", "()[Ljava/lang/reflect/Method;");
-        local_ref<jobjectArray> methods = jni::call_method<jobject>(_ref.get(), getMethods);
-
-        return method_list(_ref, methods);
-    }
-
-    method_list clazz::get_constructors()
-    {
-        // Get the java.lang.Class object associated with this class.
-        clazz cls_cls(jni::get_object_class(_ref.get()));
-
-        // Get an array of methods
-        auto getMethods = jni::get_method_id(cls_cls.native(), "getConstructors", "()[Ljava/lang/reflect/Constructor;");
-        local_ref<jobjectArray> methods = jni::call_method<jobject>(_ref.get(), getMethods);
-
-        return method_list(_ref, methods);
+            std::vector<jclass> ret;
+            ret.reserve(classes.size());
+            for (auto it = classes.begin(); it != classes.end(); it++)
+                ret.push_back(it->native());
+            return ret;
+        }
     }
 
-    java::object clazz::call_static_method(java::method m, ...)
+    const internal::resolved_method& clazz::resolve_method(const char* name, const jclass* arg_classes, size_t num_args)
     {
-        va_list args;
-        va_start(args, m);
+        auto& cache = internal::get_method_cache();
 
-        auto cls = native();
-        auto id = m.id();
-        auto return_type = m.return_type();
+        auto cached = cache.find(native(), name, arg_classes, num_args);
+        if (cached == nullptr)
+        {
+            bool is_constructor = strcmp(name, "<init>") == 0;
+            auto& table = internal::get_method_tables().get(native(), is_constructor);
+            auto match = table.resolve(name, arg_classes, num_args);
 
-        java::object ret;
+            auto resolved = match == internal::method_table::npos ? internal::resolved_method() : internal::resolve(table, match);
+            cached = &cache.insert(native(), name, arg_classes, num_args, resolved);
+        }
 
-        if (return_type == "void")
+        if (cached->id == nullptr)
         {
-            jni::call_static_methodv<void>(cls, id, args);
+            std::vector<clazz> classes;
+            for (size_t i = 0; i < num_args; i++)
+                classes.push_back(clazz(object::borrow(arg_classes[i])));
+            throw nosuchmethod_exception(*this, name, classes);
         }
-        else if (return_type == "boolean")
-            ret = object(jni::call_static_method<jboolean>(cls, id, args));
-        else if (return_type == "byte")
-            ret = object(jni::call_static_method<jbyte>(cls, id, args));
-        else if (return_type == "char")
-            ret = object(jni::call_static_method<jchar>(cls, id, args));
-        else if (return_type == "double")
-            ret = object(jni::call_static_method<jdouble>(cls, id, args));
-        else if (return_type == "float")
-            ret = object(jni::call_static_method<jfloat>(cls, id, args));
-        else if (return_type == "int")
-            ret = object(jni::call_static_method<jint>(cls, id, args));
-        else if (return_type == "long")
-            ret = object(jni::call_static_method<jlong>(cls, id, args));
-        else if (return_type == "short")
-            ret = object(jni::call_static_method<jshort>(cls, id, args));
-        else
-            ret = object(jni::call_static_method<jobject>(cls, id, args));
-
-        va_end(args);
-
-        return ret;
+
+        return *cached;
     }
 
-#define do_call_static_method(cls, id, return_type, ...) \
-    if (return_type == "void") \
-    { \
-        jni::call_static_method<void>(cls, id, __VA_ARGS__); \
-        return object(); \
-    } \
-    else if (return_type == "boolean") \
-        return object(jni::call_static_method<jboolean>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "byte") \
-        return object(jni::call_static_method<jbyte>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "char") \
-        return object(jni::call_static_method<jchar>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "double") \
-        return object(jni::call_static_method<jdouble>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "float") \
-        return object(jni::call_static_method<jfloat>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "int") \
-        return object(jni::call_static_method<jint>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "long") \
-        return object(jni::call_static_method<jlong>(cls, id, __VA_ARGS__)); \
-    else if (return_type == "short") \
-        return object(jni::call_static_method<jshort>(cls, id, __VA_ARGS__)); \
-    else \
-        return object(jni::call_static_method<jobject>(cls, id, __VA_ARGS__));
-
-    // These methods call static Java methods on the class given the 
-    // method name and a number of arguments.  An exception is thrown
-    // if an appropriate method is not found.  Also, the first method 
-    // which accepts the given arguments is called, even if there is a 
-    // "better" match.  For now, if it is necessary to disambiguate, the
-    // low-level jni::call_xxx_method() functions must be used.
-    object clazz::call_static(const char* method_name)
+    method clazz::lookup_method(const char* name, const std::vector<clazz>& classes)
     {
-        std::vector<clazz> classes;
-        auto m = lookup_method(method_name, classes);
-        do_call_static_method((jclass)_ref.get(), m.id(), m.return_type());
+        auto arg_classes = internal::native_classes(classes);
+        return method(resolve_method(name, arg_classes.data(), arg_classes.size()));
     }
-    object clazz::call_static(const char* method_name, object a1)
+
+    method clazz::lookup_constructor(const std::vector<clazz>& classes)
     {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        auto m = lookup_method(method_name, classes);
-        do_call_static_method((jclass)_ref.get(), m.id(), m.return_type(), a1.native());
+        auto arg_classes = internal::native_classes(classes);
+        return method(resolve_method("<init>", arg_classes.data(), arg_classes.size()));
     }
-    object clazz::call_static(const char* method_name, object a1, object a2)
+
+    method_list clazz::get_methods()
     {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        auto m = lookup_method(method_name, classes);
-        do_call_static_method((jclass)_ref.get(), m.id(), m.return_type(), a1.native(), a2.native());
+        return method_list(internal::get_method_tables().get(native(), false));
     }
-    object clazz::call_static(const char* method_name, object a1, object a2, object a3)
+
+    method_list clazz::get_constructors()
     {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        auto m = lookup_method(method_name, classes);
-        do_call_static_method((jclass)_ref.get(), m.id(), m.return_type(), a1.native(), a2.native(), a3.native());
+        return method_list(internal::get_method_tables().get(native(), true));
     }
 
-    object clazz::call_static(const char* method_name, object a1, object a2, object a3, object a4)
+    java::object clazz::invoke_static(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
     {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        auto m = lookup_method(method_name, classes);
-        do_call_static_method((jclass)_ref.get(), m.id(), m.return_type(), a1.native(), a2.native(), a3.native(), a4.native());
+        auto& m = resolve_method(method_name, arg_classes, num_args);
+        auto cls = native();
+
+        switch (m.return_kind)
+        {
+        case jni::void_value: jni::call_static_methoda<void>(cls, m.id, args); return object();
+        case jni::jboolean_value: return object(jni::call_static_methoda<jboolean>(cls, m.id, args));
+        case jni::jbyte_value: return object(jni::call_static_methoda<jbyte>(cls, m.id, args));
+        case jni::jchar_value: return object(jni::call_static_methoda<jchar>(cls, m.id, args));
+        case jni::jdouble_value: return object(jni::call_static_methoda<jdouble>(cls, m.id, args));
+        case jni::jfloat_value: return object(jni::call_static_methoda<jfloat>(cls, m.id, args));
+        case jni::jint_value: return object(jni::call_static_methoda<jint>(cls, m.id, args));
+        case jni::jlong_value: return object(jni::call_static_methoda<jlong>(cls, m.id, args));
+        case jni::jshort_value: return object(jni::call_static_methoda<jshort>(cls, m.id, args));
+        default: return object(jni::call_static_methoda<jobject>(cls, m.id, args));
+        }
     }
 
     java::clazz clazz::from_value(jint arg)
     {
-        return java::clazz("java/lang/Integer").static_field("TYPE");
+        return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jni::jint_value)));
     }
 
     java::clazz clazz::from_value(java::object& arg)
@@ -209,6 +148,12 @@ namespace java
     clazz java::load_class(const char* class_name, jbyte* class_data, jsize size)
     {
         auto loader = java::clazz("java/lang/ClassLoader").call_static("getSystemClassLoader");
-        return clazz(jni::define_class(class_name, loader.native(), class_data, size));
+        local_ref<jclass> cls = jni::define_class(class_name, loader.native(), class_data, size);
+
+        // Register the class for both the default lookup and the system 
+        // loader, since they resolve to the same class.
+        auto& classes = internal::get_class_registry();
+        classes.insert(class_name, loader.native(), cls.get());
+        return clazz(object::borrow(classes.insert(class_name, nullptr, cls.get())));
     }
 }
\ No newline at end of file
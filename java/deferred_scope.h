@@ -0,0 +1,36 @@
+#pragma once
+
+#include "java\jvm.h"
+
+namespace java
+{
+    // This class reports the first failure of a sequence of jni wrapper 
+    // calls made with the jni::deferred policy, e.g.:
+    //
+    //     java::deferred_scope scope;
+    //     for (jsize i = 0; i < n; i++)
+    //         sum += jni::get_field<jint, jni::deferred>(items[i], value_id);
+    //     scope.check();
+    //
+    // check() throws the Java exception left pending on the thread, if 
+    // there is one.  The destructor does the same, unless the scope is 
+    // being left because of another exception, in which case the Java 
+    // exception is left pending.  Scopes apply to the thread that created
+    // them, and may be nested: an exception that was already pending when
+    // a scope was entered belongs to an enclosing scope, and is left for 
+    // that scope to report.
+    class deferred_scope
+    {
+        bool _outer_pending;
+
+        deferred_scope(const deferred_scope&);
+        deferred_scope& operator= (const deferred_scope&);
+
+    public:
+        deferred_scope();
+
+        ~deferred_scope() noexcept(false);
+
+        void check();
+    };
+}
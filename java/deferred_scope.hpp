@@ -0,0 +1,25 @@
+
+#include "deferred_scope.h"
+#include <exception>
+
+namespace java
+{
+    deferred_scope::deferred_scope()
+        : _outer_pending(internal::get_env()->ExceptionCheck() == JNI_TRUE)
+    {
+    }
+
+    deferred_scope::~deferred_scope() noexcept(false)
+    {
+        if (std::uncaught_exception()) return;
+        check();
+    }
+
+    void deferred_scope::check()
+    {
+        if (_outer_pending) return;
+
+        auto env = internal::get_env();
+        if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+    }
+}
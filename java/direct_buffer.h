@@ -0,0 +1,68 @@
+#pragma once
+
+#include "java\object.h"
+#include <memory>
+#include <vector>
+
+namespace java
+{
+    // This class exposes memory as a java.nio.ByteBuffer without copying it,
+    // using the JNI direct buffer functions.  It works both ways: C++ memory
+    // (a std::vector, a memory mapped file, an arena, etc.) can be handed to
+    // Java APIs that accept a ByteBuffer, and a direct ByteBuffer allocated 
+    // by Java can be read and written in place from C++.
+    //
+    // The JVM doesn't know who owns memory passed to NewDirectByteBuffer, 
+    // and never frees it.  To tie the lifetime of the memory to the Java 
+    // reference, a direct_buffer can hold a shared_ptr to the owner of the
+    // memory, which is released when the direct_buffer is destroyed.  
+    // Call make_global() if the buffer needs to outlive the current native
+    // method or be used from other threads.  Either way, the
+    // C++ side must keep the direct_buffer alive for as long as Java code 
+    // may use the ByteBuffer.
+    //
+    // Note that ByteBuffers are big-endian by default.  Java code reading 
+    // multi-byte values written by C++ should call 
+    // order(ByteOrder.nativeOrder()) on the buffer first.
+    class direct_buffer : public object
+    {
+        std::shared_ptr<void> _owner;
+        void* _data;
+        jlong _capacity;
+
+    public:
+        // Wraps memory owned by the caller, who must keep it alive for the 
+        // lifetime of the Java buffer.
+        direct_buffer(void* data, jlong capacity);
+
+        // Wraps memory kept alive by owner.
+        direct_buffer(std::shared_ptr<void> owner, void* data, jlong capacity);
+
+        // Wraps the contents of a vector, which is kept alive by the buffer.
+        // The vector must not be resized while the buffer is in use.
+        template <typename T>
+        direct_buffer(std::shared_ptr<std::vector<T>> owner)
+            : object(jni::new_direct_byte_buffer(owner->data(), (jlong)(owner->size() * sizeof(T)))),
+            _owner(owner), _data(owner->data()), _capacity((jlong)(owner->size() * sizeof(T)))
+        {
+        }
+
+        // Gives access to the memory behind an existing direct 
+        // java.nio.Buffer, e.g., one returned by ByteBuffer.allocateDirect().
+        // Throws an exception if the buffer isn't a direct buffer.
+        direct_buffer(const object& buf);
+
+        // Returns the address of the buffer's memory.
+        void* data() const { return _data; }
+
+        template <typename T>
+        T* data_as() const { return static_cast<T*>(_data); }
+
+        // Returns the capacity of the buffer.  For ByteBuffers this is the 
+        // size in bytes.
+        jlong capacity() const { return _capacity; }
+
+        unsigned char* begin() const { return static_cast<unsigned char*>(_data); }
+        unsigned char* end() const { return static_cast<unsigned char*>(_data) + _capacity; }
+    };
+}
@@ -0,0 +1,25 @@
+
+#include "direct_buffer.h"
+#include "jvm.h"
+
+namespace java
+{
+    direct_buffer::direct_buffer(void* data, jlong capacity)
+        : object(jni::new_direct_byte_buffer(data, capacity)), _data(data), _capacity(capacity)
+    {
+    }
+
+    direct_buffer::direct_buffer(std::shared_ptr<void> owner, void* data, jlong capacity)
+        : object(jni::new_direct_byte_buffer(data, capacity)), _owner(owner), _data(data), _capacity(capacity)
+    {
+    }
+
+    direct_buffer::direct_buffer(const object& buf)
+        : object(buf.clone()), _data(nullptr), _capacity(0)
+    {
+        if (!buf.is_ref() || buf.is_null()) throw std::exception("Not a buffer reference");
+
+        _data = jni::get_direct_buffer_address(buf.native());
+        _capacity = jni::get_direct_buffer_capacity(buf.native());
+    }
+}
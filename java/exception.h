@@ -8,17 +8,31 @@ namespace java
 {
 
     // This class exposes Java exceptions (java.lang.Throwable) in the JVM 
-    // as C++ exceptions.
+    // as C++ exceptions.  Constructing one only takes a global reference to
+    // the throwable.  The message, stack trace and cause are fetched from
+    // the JVM the first time they are asked for, so exceptions that are
+    // caught and handled by type never pay for them.
     class exception 
         : public std::exception,
         public object
     {
-        jthrowable _t;
-        std::string _msg;
+        mutable std::string _msg;
+        mutable bool _has_msg;
 
     public:
+        // Takes a new global reference to the throwable.  The caller keeps
+        // ownership of t.
         exception(jthrowable t);
 
+        // Exceptions stay copyable, unlike other objects, since a thrown 
+        // object may be copied (by std::exception_ptr, or when caught by 
+        // value).  A copy takes another global reference.
+        exception(const exception& other)
+            : std::exception(other), object(other.object::clone()), _msg(other._msg), _has_msg(other._has_msg) {}
+
+        exception(exception&& other)
+            : std::exception(other), object(std::move(other)), _msg(std::move(other._msg)), _has_msg(other._has_msg) {}
+
         // This function clears the exception (and any other exception) that 
         // is currently being thrown in the JVM.  This is useful in order to 
         // call other functions in the java::* namespace without them 
@@ -38,6 +52,32 @@ namespace java
         // Returns a C string equivalent of what 
         // java.lang.Throwable.getMessage() returns.
         const char* what() const override;
+
+        // Returns the java.lang.Throwable that caused this one, or a null
+        // object if there is none.
+        object cause() const;
+
+        // Returns the stack trace, one "at ..." line per frame, as
+        // java.lang.Throwable.printStackTrace() would print it.
+        std::string stack_trace() const;
     };
 
+    namespace internal
+    {
+        template <typename T>
+        void throw_as(jthrowable t)
+        {
+            throw T(t);
+        }
+    }
+
+    // Makes the library throw T (which must derive from java::exception and
+    // be constructible from a jthrowable) for Java exceptions that are
+    // instances of the named class, rather than a plain java::exception.
+    template <typename T>
+    void register_exception(const char* class_name)
+    {
+        internal::get_exception_registry().add(internal::get_class_registry().find(class_name), &internal::throw_as<T>);
+    }
+
 }
\ No newline at end of file
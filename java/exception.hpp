@@ -1,24 +1,145 @@
-
 #include "exception.h"
 #include "jvm.h"
 #include "object.h"
 
 namespace java
 {
+    namespace internal
+    {
+        namespace
+        {
+            // Only a handful of JNI functions may be called while a Java
+            // exception is pending.  This clears the pending exception for
+            // the lifetime of the object, and rethrows it in the JVM when
+            // the object goes away (including during stack unwinding), so
+            // that exceptions can be inspected without disturbing the
+            // pending state.
+            class suspended_exception
+            {
+                JNIEnv* _env;
+                jthrowable _t;
+
+            public:
+                suspended_exception(JNIEnv* env)
+                    : _env(env), _t(env->ExceptionCheck() ? env->ExceptionOccurred() : nullptr)
+                {
+                    if (_t != nullptr) _env->ExceptionClear();
+                }
+
+                ~suspended_exception()
+                {
+                    if (_t == nullptr) return;
+                    _env->Throw(_t);
+                    _env->DeleteLocalRef(_t);
+                }
+
+                jthrowable get() const { return _t; }
+            };
+
+            // Calls a Throwable method returning a String, and converts the
+            // result.  Any exception thrown by the method itself is dropped.
+            bool call_string_method(JNIEnv* env, jobject obj, jmethodID id, std::string& result)
+            {
+                auto str = (jstring)env->CallObjectMethod(obj, id);
+                if (env->ExceptionCheck())
+                {
+                    env->ExceptionClear();
+                    return false;
+                }
+
+                if (str == nullptr) return false;
+                result = jstring_str(str);
+                env->DeleteLocalRef(str);
+                return true;
+            }
+        }
+
+        void throw_pending_exception(JNIEnv* env)
+        {
+            suspended_exception pending(env);
+            if (pending.get() == nullptr) throw std::exception("No Java exception is pending");
+
+            auto thrower = get_exception_registry().find(pending.get());
+            if (thrower != nullptr) thrower(pending.get());
+            throw exception(pending.get());
+        }
+    }
+
     exception::exception(jthrowable t)
-        : _t(t), _msg(""), object(t)
+        : object(), _msg(""), _has_msg(false)
     {
-        suspend();
-        auto msg = call("getMessage");
-		_msg = msg.is_null() ? "(null)" : msg.as_string();
-        resume();
+        internal::suspended_exception pending(internal::get_env());
+        *static_cast<object*>(this) = object(global_ref<jobject>(jni::new_global_ref(t)));
     }
 
     const char* exception::what() const
     {
+        if (_has_msg) return _msg.c_str();
+
+        try
+        {
+            auto env = internal::get_env();
+            internal::suspended_exception pending(env);
+            auto id = internal::get_exception_registry().method(internal::throwable_get_message);
+            if (!internal::call_string_method(env, native(), id, _msg)) _msg = "(null)";
+        }
+        catch (...)
+        {
+            _msg = "(unavailable)";
+        }
+
+        _has_msg = true;
         return _msg.c_str();
     }
 
+    object exception::cause() const
+    {
+        auto env = internal::get_env();
+        internal::suspended_exception pending(env);
+        auto id = internal::get_exception_registry().method(internal::throwable_get_cause);
+        jobject cause = env->CallObjectMethod(native(), id);
+        if (env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+            return object::null();
+        }
+
+        return object(cause);
+    }
+
+    std::string exception::stack_trace() const
+    {
+        auto env = internal::get_env();
+        internal::suspended_exception pending(env);
+        auto& registry = internal::get_exception_registry();
+
+        std::string ret;
+        if (!internal::call_string_method(env, native(), registry.method(internal::object_to_string), ret))
+            ret = "(unknown)";
+
+        auto frames = (jobjectArray)env->CallObjectMethod(native(), registry.method(internal::throwable_get_stack_trace));
+        if (env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+            return ret;
+        }
+        if (frames == nullptr) return ret;
+
+        auto to_string = registry.method(internal::object_to_string);
+        jsize size = env->GetArrayLength(frames);
+        for (jsize i = 0; i < size; i++)
+        {
+            jobject frame = env->GetObjectArrayElement(frames, i);
+            std::string line;
+            if (internal::call_string_method(env, frame, to_string, line))
+                ret += "\n\tat " + line;
+            env->DeleteLocalRef(frame);
+        }
+
+        env->DeleteLocalRef(frames);
+        return ret;
+    }
+
     void exception::suspend()
     {
         internal::get_env()->ExceptionClear();
@@ -26,16 +147,14 @@ namespace java
 
     void exception::resume()
     {
-        internal::get_env()->Throw(_t);
+        internal::get_env()->Throw((jthrowable)native());
     }
 
     void exception::print()
     {
-        suspend();
-        object t(_t);
-
-        std::string ret;
-        t.call("printStackTrace");
-        resume();
+        auto env = internal::get_env();
+        internal::suspended_exception pending(env);
+        env->CallVoidMethod(native(), internal::get_exception_registry().method(internal::throwable_print_stack_trace));
+        if (env->ExceptionCheck()) env->ExceptionClear();
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "jni.h"
+#include <atomic>
+
+namespace java
+{
+    namespace internal
+    {
+        // Throws a C++ exception wrapping the given throwable.  Each
+        // registered exception type gets one of these, instantiated by
+        // java::register_exception.
+        typedef void (*exception_thrower)(jthrowable t);
+
+        // The java.lang.Throwable methods used to fill in the details of a
+        // java::exception on demand.
+        enum throwable_method
+        {
+            throwable_get_message,
+            throwable_get_cause,
+            throwable_get_stack_trace,
+            throwable_print_stack_trace,
+            object_to_string,
+            throwable_method_count
+        };
+
+        // This class maps Java exception classes to the C++ exception types
+        // that should be thrown for them, and caches the method ID's used to
+        // inspect throwables.  Registrations are checked most recent first
+        // with IsInstanceOf, so register a subclass after its superclass to
+        // give it its own C++ type.  Like the other per-VM caches, entries
+        // are published with an atomic push and readers never take a lock.
+        class exception_registry
+        {
+            struct entry
+            {
+                jclass cls;
+                exception_thrower thrower;
+                entry* next;
+            };
+
+            std::atomic<entry*> _entries;
+            std::atomic<jmethodID> _methods[throwable_method_count];
+
+            exception_registry(const exception_registry&);
+            exception_registry& operator= (const exception_registry&);
+
+        public:
+            exception_registry();
+            ~exception_registry();
+
+            // Registers a thrower for instances of cls.  The class must be a
+            // global reference that outlives the registry (e.g., one owned
+            // by the class registry).
+            void add(jclass cls, exception_thrower thrower);
+
+            // Returns the thrower registered for the throwable's class, or
+            // nullptr if the base java::exception should be thrown.  No Java
+            // exception may be pending.
+            exception_thrower find(jthrowable t);
+
+            jmethodID method(throwable_method m);
+
+            // Forgets all registrations and method ID's.
+            void clear();
+        };
+    }
+}
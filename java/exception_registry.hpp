@@ -0,0 +1,95 @@
+
+#include "exception_registry.h"
+#include "jvm.h"
+
+namespace java
+{
+    namespace internal
+    {
+        namespace
+        {
+            struct throwable_method_info
+            {
+                const char* class_name;
+                const char* name;
+                const char* signature;
+            };
+
+            // Indexed by throwable_method
+            const throwable_method_info throwable_methods[] = {
+                { "java/lang/Throwable", "getMessage", "()Ljava/lang/String;" },
+                { "java/lang/Throwable", "getCause", "()Ljava/lang/Throwable;" },
+                { "java/lang/Throwable", "getStackTrace", "()[Ljava/lang/StackTraceElement;" },
+                { "java/lang/Throwable", "printStackTrace", "()V" },
+                { "java/lang/Object", "toString", "()Ljava/lang/String;" },
+            };
+        }
+
+        exception_registry::exception_registry()
+            : _entries(nullptr)
+        {
+            for (size_t i = 0; i < throwable_method_count; i++)
+                _methods[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        exception_registry::~exception_registry()
+        {
+            // The classes are owned by the class registry, so only the
+            // memory is released here.
+            entry* e = _entries.exchange(nullptr);
+            while (e != nullptr)
+            {
+                entry* next = e->next;
+                delete e;
+                e = next;
+            }
+        }
+
+        void exception_registry::add(jclass cls, exception_thrower thrower)
+        {
+            entry* e = new entry();
+            e->cls = cls;
+            e->thrower = thrower;
+
+            e->next = _entries.load(std::memory_order_relaxed);
+            while (!_entries.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+
+        exception_thrower exception_registry::find(jthrowable t)
+        {
+            auto env = get_env();
+            for (entry* e = _entries.load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (env->IsInstanceOf(t, e->cls)) return e->thrower;
+            }
+            return nullptr;
+        }
+
+        jmethodID exception_registry::method(throwable_method m)
+        {
+            jmethodID id = _methods[m].load(std::memory_order_acquire);
+            if (id != nullptr) return id;
+
+            // Racing threads resolve the same ID, so there's nothing to undo
+            auto& info = throwable_methods[m];
+            id = jni::get_method_id(get_class_registry().find(info.class_name), info.name, info.signature);
+            _methods[m].store(id, std::memory_order_release);
+            return id;
+        }
+
+        void exception_registry::clear()
+        {
+            entry* e = _entries.exchange(nullptr);
+            while (e != nullptr)
+            {
+                entry* next = e->next;
+                delete e;
+                e = next;
+            }
+
+            for (size_t i = 0; i < throwable_method_count; i++)
+                _methods[i].store(nullptr);
+        }
+    }
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "java\jvm.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace java
+{
+    class object;
+
+    namespace internal
+    {
+        // A type-erased, move-only callable.  std::function requires the
+        // callable to be copyable, which rules out tasks holding promises,
+        // unique_ptrs and the like.
+        class task
+        {
+            struct base
+            {
+                virtual ~base() {}
+                virtual void run() = 0;
+            };
+
+            template <typename F>
+            struct impl : base
+            {
+                F f;
+
+                template <typename G>
+                impl(G&& g) : f(std::forward<G>(g)) {}
+
+                void run() override { f(); }
+            };
+
+            std::unique_ptr<base> _impl;
+
+            task(const task&);
+            task& operator= (const task&);
+
+        public:
+            task() {}
+
+            template <typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, task>::value>::type>
+            task(F&& f) : _impl(new impl<typename std::decay<F>::type>(std::forward<F>(f))) {}
+
+            task(task&& other) : _impl(std::move(other._impl)) {}
+
+            task& operator= (task&& rhs)
+            {
+                _impl = std::move(rhs._impl);
+                return *this;
+            }
+
+            void operator() () { _impl->run(); }
+
+            explicit operator bool() const { return _impl != nullptr; }
+        };
+
+        // A future may be read, and destroyed, on a thread that isn't 
+        // attached to the JVM, so what a task leaves in it must not depend
+        // on the worker's local frame or thread.  Objects are turned into 
+        // global references, and exceptions holding a Java reference (such
+        // as java::exception) into a std::runtime_error with their message.
+        template <typename T>
+        typename std::enable_if<!std::is_base_of<object, T>::value>::type make_portable(T&) {}
+
+        template <typename T>
+        typename std::enable_if<std::is_base_of<object, T>::value>::type make_portable(T& value) { value.make_global(); }
+
+        std::exception_ptr make_portable(std::exception_ptr ex);
+
+        // Runs a callable and hands its result (or exception) to a promise.
+        template <typename R, typename F>
+        struct promised_task
+        {
+            std::promise<R> promise;
+            F f;
+
+            promised_task(F&& f) : f(std::move(f)) {}
+            promised_task(promised_task&& other) : promise(std::move(other.promise)), f(std::move(other.f)) {}
+
+            void operator() ()
+            {
+                try
+                {
+                    R value = f();
+                    make_portable(value);
+                    promise.set_value(std::move(value));
+                }
+                catch (...) { promise.set_exception(make_portable(std::current_exception())); }
+            }
+        };
+
+        template <typename F>
+        struct promised_task<void, F>
+        {
+            std::promise<void> promise;
+            F f;
+
+            promised_task(F&& f) : f(std::move(f)) {}
+            promised_task(promised_task&& other) : promise(std::move(other.promise)), f(std::move(other.f)) {}
+
+            void operator() ()
+            {
+                try
+                {
+                    f();
+                    promise.set_value();
+                }
+                catch (...) { promise.set_exception(make_portable(std::current_exception())); }
+            }
+        };
+    }
+
+    // This class owns a fixed pool of threads that stay attached to the JVM
+    // for as long as the executor exists, so that tasks can use the java::*
+    // API without paying for AttachCurrentThread/DetachCurrentThread (and
+    // the java.lang.Thread object the JVM creates for every attach).  Tasks
+    // can be submitted from any thread, attached or not.
+    //
+    // Each worker has its own deque of tasks.  Tasks submitted from outside
+    // the pool are dealt out round-robin; tasks submitted by a worker go on
+    // its own deque, which it works through newest first while idle workers
+    // steal the oldest tasks from the others.  Every task runs inside its
+    // own local_frame, so local references it creates are freed when it
+    // returns.  A java::object returned by a task is turned into a global
+    // reference before the frame is popped, and a java::exception thrown 
+    // by one reaches the future as a std::runtime_error holding its 
+    // message, so futures of other results can be used on any thread.  A 
+    // future holding a java::object must still be read and destroyed on a
+    // thread that is attached to the JVM (or can attach on demand); 
+    // submitters that aren't should return a C++ value instead.
+    //
+    // Destroying the executor runs the tasks that are still queued, then
+    // detaches and joins the threads.  The vm must outlive the executor.
+    class executor
+    {
+        struct worker
+        {
+            std::mutex lock;
+            std::deque<internal::task> tasks;
+            std::thread thread;
+        };
+
+        vm& _jvm;
+        std::vector<std::unique_ptr<worker>> _workers;
+
+        // Idle workers sleep on the condition variable until the pending
+        // count goes up or the executor is stopped.
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::atomic<size_t> _pending;
+        std::atomic<size_t> _next;
+        bool _stopping;
+
+        void push(internal::task t);
+        bool pop(size_t index, internal::task& t);
+        void run(size_t index);
+
+        executor(const executor&);
+        executor& operator= (const executor&);
+
+    public:
+        // Starts the given number of threads (by default one per hardware
+        // thread) and attaches them to the JVM.
+        explicit executor(vm& jvm, size_t num_threads = 0);
+        ~executor();
+
+        size_t size() const { return _workers.size(); }
+
+        // Queues a callable taking no arguments, and returns a future for
+        // its result.  An exception thrown by the callable is stored in the
+        // future (as a std::runtime_error, for exceptions that hold a Java
+        // reference).  The callable may be move-only.
+        template <typename F>
+        std::future<typename std::result_of<typename std::decay<F>::type()>::type> submit(F&& f)
+        {
+            typedef typename std::decay<F>::type callable;
+            typedef typename std::result_of<callable()>::type result_type;
+
+            internal::promised_task<result_type, callable> job(callable(std::forward<F>(f)));
+            auto future = job.promise.get_future();
+            push(internal::task(std::move(job)));
+            return future;
+        }
+    };
+}
@@ -0,0 +1,169 @@
+
+#include "executor.h"
+#include "local_frame.h"
+#include "object.h"
+#include <stdexcept>
+
+namespace java
+{
+    namespace internal
+    {
+        std::exception_ptr make_portable(std::exception_ptr ex)
+        {
+            try
+            {
+                std::rethrow_exception(ex);
+            }
+            catch (const std::exception& e)
+            {
+                // what() reads a java::exception's message from the JVM, 
+                // which has to happen here, on the worker.
+                if (dynamic_cast<const object*>(&e) != nullptr)
+                    return std::make_exception_ptr(std::runtime_error(e.what()));
+            }
+            catch (...)
+            {
+            }
+            return ex;
+        }
+    }
+
+    namespace
+    {
+#ifndef JAVA_NO_THREAD_LOCAL
+        // The executor and worker index of the current thread, if it is a
+        // worker, so that tasks it submits go on its own deque.
+        thread_local executor* tlsExecutor = nullptr;
+        thread_local size_t tlsWorker = 0;
+#endif
+    }
+
+    executor::executor(vm& jvm, size_t num_threads)
+        : _jvm(jvm), _pending(0), _next(0), _stopping(false)
+    {
+        if (num_threads == 0) num_threads = std::thread::hardware_concurrency();
+        if (num_threads == 0) num_threads = 1;
+
+        for (size_t i = 0; i < num_threads; i++)
+            _workers.push_back(std::unique_ptr<worker>(new worker()));
+
+        // The deques must all exist before any thread starts stealing
+        for (size_t i = 0; i < num_threads; i++)
+            _workers[i]->thread = std::thread(&executor::run, this, i);
+    }
+
+    executor::~executor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+
+        for (auto it = _workers.begin(); it != _workers.end(); it++)
+        {
+            if ((*it)->thread.joinable()) (*it)->thread.join();
+        }
+    }
+
+    void executor::push(internal::task t)
+    {
+        size_t index;
+#ifndef JAVA_NO_THREAD_LOCAL
+        if (tlsExecutor == this) index = tlsWorker;
+        else
+#endif
+        index = _next.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+
+        {
+            auto& w = *_workers[index];
+            std::lock_guard<std::mutex> lock(w.lock);
+            w.tasks.push_back(std::move(t));
+        }
+
+        // Taking the mutex orders the increment with a worker that has just
+        // checked the count and is about to wait, so the wakeup isn't lost.
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pending.fetch_add(1);
+        }
+        _wake.notify_one();
+    }
+
+    bool executor::pop(size_t index, internal::task& t)
+    {
+        // Newest first from the worker's own deque, which is likely to still
+        // be in cache...
+        {
+            auto& own = *_workers[index];
+            std::lock_guard<std::mutex> lock(own.lock);
+            if (!own.tasks.empty())
+            {
+                t = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                _pending.fetch_sub(1);
+                return true;
+            }
+        }
+
+        // ...then oldest first from everyone else's.
+        for (size_t i = 1; i < _workers.size(); i++)
+        {
+            auto& victim = *_workers[(index + i) % _workers.size()];
+            std::lock_guard<std::mutex> lock(victim.lock);
+            if (!victim.tasks.empty())
+            {
+                t = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                _pending.fetch_sub(1);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void executor::run(size_t index)
+    {
+        _jvm.attach_thread();
+#ifndef JAVA_NO_THREAD_LOCAL
+        tlsExecutor = this;
+        tlsWorker = index;
+#endif
+
+        for (;;)
+        {
+            internal::task t;
+            if (pop(index, t))
+            {
+                try
+                {
+                    local_frame frame;
+                    t();
+                }
+                catch (...)
+                {
+                    // Submitted tasks report their exceptions through their
+                    // futures, so this only catches a failure to push the
+                    // frame.
+                }
+
+                // A java::exception leaves its throwable pending; its 
+                // message now lives in the task's future, so don't let it 
+                // leak into the next task.
+                auto env = internal::get_env();
+                if (env->ExceptionCheck()) env->ExceptionClear();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(_mutex);
+            if (_stopping && _pending.load() == 0) break;
+            _wake.wait(lock, [this] { return _stopping || _pending.load() > 0; });
+        }
+
+#ifndef JAVA_NO_THREAD_LOCAL
+        tlsExecutor = nullptr;
+#endif
+        _jvm.detach_thread();
+    }
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "java\object.h"
+#include "java\clazz.h"
+
+namespace java
+{
+    // A non-static field resolved ahead of time by clazz::find_field.
+    // Where object::get and object::set look the field up in the member
+    // cache on every access (which takes the object's class and compares
+    // it with the cached one), each get or set through a handle is a
+    // single Get/Set<Type>Field call on the stored ID.  Resolve handles
+    // once, outside of hot loops:
+    //
+    //     auto price = java::clazz("com/example/Event").find_field<jdouble>("price");
+    //     for (...) total += price.get(event);
+    //
+    // The handle is valid for instances of the class it was found in and
+    // of its subclasses, for the lifetime of the JVM, and can be copied
+    // and shared between threads.  Nothing checks that the target really
+    // is such an instance.
+    template <typename jtype>
+    class field_handle
+    {
+        jfieldID _id;
+
+        static jobject target_of(const object& target)
+        {
+            if (!target.is_ref() || target.native() == nullptr) throw std::exception("Field accessed on a null reference");
+            return target.native();
+        }
+
+    public:
+        field_handle() : _id(nullptr) {}
+        explicit field_handle(jfieldID id) : _id(id) {}
+
+        jfieldID native() const { return _id; }
+
+        typename internal::field_access<jtype>::type get(const object& target) const
+        {
+            return internal::field_access<jtype>::get(target_of(target), _id);
+        }
+
+        void set(const object& target, typename internal::field_access<jtype>::param_type value) const
+        {
+            internal::field_access<jtype>::set(target_of(target), _id, value);
+        }
+    };
+
+    // The same for a static field, found by clazz::find_static_field.  The
+    // handle holds the member cache's global reference to the class, so
+    // it doesn't depend on the clazz it was found through.
+    template <typename jtype>
+    class static_field_handle
+    {
+        jclass _cls;
+        jfieldID _id;
+
+    public:
+        static_field_handle() : _cls(nullptr), _id(nullptr) {}
+        static_field_handle(jclass cls, jfieldID id) : _cls(cls), _id(id) {}
+
+        jfieldID native() const { return _id; }
+
+        typename internal::field_access<jtype>::type get() const
+        {
+            return internal::field_access<jtype>::get_static(_cls, _id);
+        }
+
+        void set(typename internal::field_access<jtype>::param_type value) const
+        {
+            internal::field_access<jtype>::set_static(_cls, _id, value);
+        }
+    };
+
+    template <typename jtype>
+    field_handle<jtype> clazz::find_field(const char* name) const
+    {
+        return field_handle<jtype>(internal::get_member_cache().resolve_field(native(), internal::instance_field, name, jni::descriptor<jtype>::type::value));
+    }
+
+    template <typename jtype>
+    static_field_handle<jtype> clazz::find_static_field(const char* name) const
+    {
+        jclass cls;
+        auto id = internal::get_member_cache().resolve_field(native(), internal::static_field, name, jni::descriptor<jtype>::type::value, &cls);
+        return static_field_handle<jtype>(cls, id);
+    }
+}
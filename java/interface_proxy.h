@@ -2,10 +2,104 @@
 
 #include "..\java.h"
 #include <functional>
+#include <map>
+#include <string>
 
 namespace java
 {
 	typedef std::function<object(method, object)> invocation_handler_func;
 
-	object create_proxy(clazz iface, invocation_handler_func handler);
+	// Handles calls to one method of a proxy.  The argument is the Object[]
+	// of boxed arguments, which is null if the method takes none.
+	typedef std::function<object(object)> proxy_method_func;
+
+	// Maps the methods of an interface to their handlers.  Keys are a 
+	// method name followed by its JNI signature, e.g., 
+	// "compare(Ljava/lang/Object;Ljava/lang/Object;)I".
+	typedef std::map<std::string, proxy_method_func> proxy_method_map;
+
+	namespace internal
+	{
+		template <size_t... I> struct index_list {};
+		template <size_t N, size_t... I> struct make_index_list : make_index_list<N - 1, N - 1, I...> {};
+		template <size_t... I> struct make_index_list<0, I...> { typedef index_list<I...> type; };
+
+		// Unboxes an element of a proxy call's Object[] into the type of a
+		// typed handler's parameter.  References are passed as they are.
+		template <typename T> struct proxy_arg;
+		template <> struct proxy_arg<object> { static object from(object value) { return value; } };
+		template <> struct proxy_arg<jboolean> { static jboolean from(const object& value) { return value.as_bool() ? JNI_TRUE : JNI_FALSE; } };
+		template <> struct proxy_arg<jbyte> { static jbyte from(const object& value) { return value.as_byte(); } };
+		template <> struct proxy_arg<jchar> { static jchar from(const object& value) { return value.as_char(); } };
+		template <> struct proxy_arg<jshort> { static jshort from(const object& value) { return value.as_short(); } };
+		template <> struct proxy_arg<jint> { static jint from(const object& value) { return value.as_int(); } };
+		template <> struct proxy_arg<jlong> { static jlong from(const object& value) { return value.as_long(); } };
+		template <> struct proxy_arg<jfloat> { static jfloat from(const object& value) { return value.as_float(); } };
+		template <> struct proxy_arg<jdouble> { static jdouble from(const object& value) { return value.as_double(); } };
+
+		inline object proxy_arg_at(const object& args, size_t index)
+		{
+			return object(jni::get_object_array_element((jobjectArray)args.native(), (jsize)index));
+		}
+
+		template <typename sig>
+		struct typed_proxy_method;
+
+		template <typename R, typename... Args>
+		struct typed_proxy_method<R(Args...)>
+		{
+			typedef typename make_index_list<sizeof...(Args)>::type indices;
+
+			template <typename F, size_t... I>
+			static object call(F& f, const object& args, index_list<I...>)
+			{
+				return object(f(proxy_arg<Args>::from(proxy_arg_at(args, I))...));
+			}
+		};
+
+		template <typename... Args>
+		struct typed_proxy_method<void(Args...)>
+		{
+			typedef typename make_index_list<sizeof...(Args)>::type indices;
+
+			template <typename F, size_t... I>
+			static object call(F& f, const object& args, index_list<I...>)
+			{
+				f(proxy_arg<Args>::from(proxy_arg_at(args, I))...);
+				return object();
+			}
+		};
+	}
+
+	// Wraps a handler taking the method's arguments as C++ values, for a 
+	// proxy_method_map.  The signature uses JNI primitives and 
+	// java::object, like native_implementation's handlers, and the boxed
+	// arguments are unboxed into it; the result is boxed again, e.g.:
+	//
+	//     methods["compare(Ljava/lang/Object;Ljava/lang/Object;)I"] = 
+	//         java::proxy_method<jint(java::object, java::object)>(
+	//             [](java::object a, java::object b) -> jint { ... });
+	//
+	// Arguments still arrive boxed in an Object[], so this saves writing 
+	// the unboxing rather than its cost; native_implementation avoids both.
+	template <typename sig, typename F>
+	proxy_method_func proxy_method(F handler)
+	{
+		return [handler](object args) mutable -> object
+		{
+			typedef internal::typed_proxy_method<sig> invoker;
+			return invoker::call(handler, args, typename invoker::indices());
+		};
+	}
+
+	object create_proxy(const clazz& iface, invocation_handler_func handler);
+
+	// Creates a proxy whose methods are dispatched through a table.  The 
+	// keys are resolved to method ID's here, once, so each call costs a 
+	// hash lookup on the ID of the invoked method instead of building a
+	// java::method and comparing names.  Calls to methods that aren't in
+	// the table (such as Object.toString, unless it is listed) go to the
+	// fallback handler, or throw UnsupportedOperationException if there is
+	// none.  Throws an exception if a key doesn't name a method of iface.
+	object create_proxy(const clazz& iface, const proxy_method_map& methods, invocation_handler_func fallback = nullptr);
 }
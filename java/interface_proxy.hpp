@@ -1,6 +1,58 @@
 #pragma once
 
 #include "interface_proxy.h"
+#include <unordered_map>
+
+namespace java
+{
+	namespace internal
+	{
+		// The NativeInvocationHandler's ptr field points to one of these.
+		class proxy_handler
+		{
+		public:
+			virtual ~proxy_handler() {}
+			virtual object invoke(jobject methodObj, jobjectArray args) = 0;
+		};
+
+		// Passes every call to a single function, along with the method.
+		class function_handler : public proxy_handler
+		{
+			invocation_handler_func _handler;
+
+		public:
+			function_handler(invocation_handler_func handler) : _handler(handler) {}
+
+			object invoke(jobject methodObj, jobjectArray args) override
+			{
+				return _handler(method(methodObj), args);
+			}
+		};
+
+		// Looks the invoked method up by ID in a table built by create_proxy.
+		class dispatch_handler : public proxy_handler
+		{
+			std::unordered_map<jmethodID, proxy_method_func> _methods;
+			invocation_handler_func _fallback;
+
+		public:
+			dispatch_handler(std::unordered_map<jmethodID, proxy_method_func> methods, invocation_handler_func fallback)
+				: _methods(std::move(methods)), _fallback(fallback) {}
+
+			object invoke(jobject methodObj, jobjectArray args) override
+			{
+				auto it = _methods.find(jni::from_reflected_method(methodObj));
+				if (it != _methods.end()) return it->second(args);
+				if (_fallback) return _fallback(method(methodObj), args);
+
+				auto env = get_env();
+				local_ref<jclass> cls = env->FindClass("java/lang/UnsupportedOperationException");
+				if (cls) env->ThrowNew(cls.get(), "No handler for the proxied method");
+				return object::null();
+			}
+		};
+	}
+}
 
 extern "C"
 {
@@ -11,15 +63,44 @@ extern "C"
 		jobject methodObj,
 		jobjectArray args)
 	{
-		java::invocation_handler_func* ptrHandler = reinterpret_cast<java::invocation_handler_func*>(ptr);
-		auto ret = (*ptrHandler)(java::method(methodObj), args);
-
-		// This is absolutely critical.  We must create an additional reference to 
-		// the object we are returning, as the java::object returned by 
-		// java::create() will release it's reference to the object as the function 
-		// is returning.  If we don't get an additional reference, the object will 
-		// basically be destroyed before the JVM can use it.
-		return java::internal::get_env()->NewLocalRef(ret.box().native());
+		try
+		{
+			auto handler = reinterpret_cast<java::internal::proxy_handler*>(ptr);
+			auto ret = handler->invoke(methodObj, args);
+			if (env->ExceptionCheck()) return nullptr;
+
+			// This is absolutely critical.  We must create an additional reference to 
+			// the object we are returning, as the java::object returned by 
+			// java::create() will release it's reference to the object as the function 
+			// is returning.  If we don't get an additional reference, the object will 
+			// basically be destroyed before the JVM can use it.
+			return env->NewLocalRef(ret.box().native());
+		}
+		catch (const java::exception&)
+		{
+			// The Java exception is still pending, and is thrown to the 
+			// caller of the proxy method when this returns.
+			return nullptr;
+		}
+		catch (const std::exception& e)
+		{
+			// C++ exceptions must not unwind through JVM frames.
+			if (!env->ExceptionCheck())
+			{
+				jclass cls = env->FindClass("java/lang/RuntimeException");
+				if (cls != nullptr) env->ThrowNew(cls, e.what());
+			}
+			return nullptr;
+		}
+		catch (...)
+		{
+			if (!env->ExceptionCheck())
+			{
+				jclass cls = env->FindClass("java/lang/RuntimeException");
+				if (cls != nullptr) env->ThrowNew(cls, "Unknown C++ exception in proxy handler");
+			}
+			return nullptr;
+		}
 	}
 
 	void JNICALL NativeInvocationHandler_finalizeNative(
@@ -27,8 +108,7 @@ extern "C"
 		jobject self,
 		jlong ptr)
 	{
-		java::invocation_handler_func* ptrHandler = reinterpret_cast<java::invocation_handler_func*>(ptr);
-		delete ptrHandler;
+		delete reinterpret_cast<java::internal::proxy_handler*>(ptr);
 	}
 }
 
@@ -94,17 +174,45 @@ namespace java
 			methods[1].name = "finalizeNative";
 			methods[1].signature = "(J)V";
 			jni::register_natives(nih.native(), methods, 2);
+			get_thread_context().vm->prox_class_loaded = true;
+		}
+
+		// Takes ownership of the handler, which the proxy's 
+		// NativeInvocationHandler deletes when it is finalized.
+		object make_proxy(const clazz& iface, proxy_handler* handler)
+		{
+			std::unique_ptr<proxy_handler> owned(handler);
+
+			internal::thread_context* context = &internal::get_thread_context();
+			if (!context->vm->prox_class_loaded)
+				internal::initialize_proxy();
+
+			clazz nativeHandlerClass("proxy/NativeInvocationHandler");
+			auto ret = nativeHandlerClass.call_static("makeProxy", iface, reinterpret_cast<jlong>(handler));
+			owned.release();
+			return ret;
 		}
 	}
 
-	object create_proxy(clazz iface, invocation_handler_func handler)
+	object create_proxy(const clazz& iface, invocation_handler_func handler)
 	{
-		internal::thread_context* context = (internal::thread_context*)internal::get_tls_value();
-		if (!context->vm->prox_class_loaded)
-			internal::initialize_proxy();
+		return internal::make_proxy(iface, new internal::function_handler(handler));
+	}
+
+	object create_proxy(const clazz& iface, const proxy_method_map& methods, invocation_handler_func fallback)
+	{
+		std::unordered_map<jmethodID, proxy_method_func> table;
+		for (auto it = methods.begin(); it != methods.end(); it++)
+		{
+			auto paren = it->first.find('(');
+			if (paren == 0 || paren == std::string::npos)
+				throw std::exception("Proxy method keys must be a method name followed by a JNI signature");
+
+			auto name = it->first.substr(0, paren);
+			auto id = jni::get_method_id(iface.native(), name.c_str(), it->first.c_str() + paren);
+			table[id] = it->second;
+		}
 
-		clazz nativeHandlerClass("proxy/NativeInvocationHandler");
-		return nativeHandlerClass.call_static("makeProxy", iface,
-			reinterpret_cast<jlong>(new invocation_handler_func(handler)));
+		return internal::make_proxy(iface, new internal::dispatch_handler(std::move(table), fallback));
 	}
 }
\ No newline at end of file
@@ -1,13 +1,21 @@
 #pragma once
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#else
+#include <pthread.h>
+#include <dlfcn.h>
+#endif
 
 #include "jni.h"
 
 #include "java\type_traits.h"
+#include "java\method_cache.h"
+#include "java\member_cache.h"
 #include <vector>
 #include <memory>
+#include <string>
 
 #ifdef DEBUG_REFS
 #include <list>
@@ -21,28 +29,73 @@ namespace java
 		{
 			bool prox_class_loaded;
 			JavaVM* jvm;
+			method_cache methods;
+			member_cache members;
+			class_registry classes;
+			boxing_cache boxing;
+			method_table_cache tables;
+			string_cache strings;
+			exception_registry exceptions;
+
+			// The JavaVMAttachArgs used for threads attached on demand (see
+			// vm::enable_auto_attach).  The group is a global reference.
+			std::string attach_name;
+			jobject attach_group;
 
 			vm_context(JavaVM* j)
-				: jvm(j), prox_class_loaded(false) {}
+				: jvm(j), prox_class_loaded(false), attach_group(nullptr) {}
 		};
 
+		// Returns the number of JVMs that have been destroyed so far.
+		unsigned get_vm_generation();
+
+		// Marks the thread contexts that exist so far as belonging to a 
+		// JVM that is gone, so the thread exit hook doesn't detach them.
+		void invalidate_thread_contexts();
+
 		struct thread_context
 		{
 			JNIEnv* env;
 			vm_context* vm;
 
-			thread_context(vm_context* vm, JNIEnv* e)
-				: vm(vm), env(e) {}
+			// True if the library attached the thread to the JVM, in which 
+			// case it is detached when the thread exits.
+			bool attached;
+
+			// The number of java::local_frame objects active on the thread
+			int frame_depth;
+
+			// The thread exit hook may run after the vm (and its 
+			// vm_context) is destroyed, so it detaches through its own copy
+			// of the JavaVM pointer, and only if no JVM has been destroyed 
+			// since the context was created.
+			JavaVM* jvm;
+			unsigned generation;
+
+			thread_context(vm_context* vm, JNIEnv* e, bool attached = false)
+				: vm(vm), env(e), attached(attached), frame_depth(0), jvm(vm->jvm), generation(get_vm_generation()) {}
 		};
 
+#ifdef _WIN32
+        typedef DWORD tls_index_type;
+#else
+        typedef pthread_key_t tls_index_type;
+#endif
+
         // This function returns the TLS index used by the library to store 
         // the thread-local JNIEnv pointer, allocating the index if 
-        // neccessary.
-        DWORD get_tls_index();
-
-        // These function get/set the TLS value stored at the index.
-        LPVOID get_tls_value();
-        void set_tls_value(LPVOID);
+        // neccessary.  On POSIX platforms this is a pthread key, which is
+        // also used to detach threads from the JVM when they exit.
+        tls_index_type get_tls_index();
+
+        // These function get/set the thread's context pointer.  Unless 
+        // JAVA_NO_THREAD_LOCAL is defined, the pointer is kept in a C++11 
+        // thread_local variable, so that reading it is just a memory access
+        // instead of a call into the OS.  The TLS index (Windows) or pthread
+        // key (POSIX) is then only used as a fallback when thread_local 
+        // isn't available, and to hook thread exit on POSIX.
+        void* get_tls_value();
+        void set_tls_value(void*);
 
         // This function can be used to free the TLS index, although the
         // library does not currently call it.  It should be called whenever
@@ -53,8 +106,18 @@ namespace java
         // it's probably not a big deal not to free the index anyway.
         void free_tls_index();
 
+		// Returns the current thread's context.  If the thread isn't 
+		// attached, it is attached on demand when that is enabled, and an
+		// exception is thrown otherwise.
 		thread_context& get_thread_context();
 
+		// Sets the JVM that unattached threads are attached to on first use
+		// of the library, or null to throw instead.
+		void set_auto_attach_vm(vm_context* vm);
+
+		// Returns the JVM set by set_auto_attach_vm, or null.
+		vm_context* get_auto_attach_vm();
+
 		void delete_thread_context();
 
 		void set_thread_context(const thread_context& context);
@@ -64,6 +127,44 @@ namespace java
         // exception if the thread is not attached.
         JNIEnv* get_env();
 
+        // Returns true if a java::local_frame is active on the current 
+        // thread, in which case local references are freed by the frame 
+        // rather than individually.
+        bool in_local_frame();
+
+        // Returns the cache of resolved methods for the JVM the current
+        // thread is attached to.
+        method_cache& get_method_cache();
+
+        // Returns the cache of method and field ID's that were resolved 
+        // using explicit JNI signatures.
+        member_cache& get_member_cache();
+
+        // Returns the registry of global class references for the JVM the
+        // current thread is attached to.
+        class_registry& get_class_registry();
+
+        // Returns the primitive wrapper classes and methods for the JVM the
+        // current thread is attached to.
+        boxing_cache& get_boxing_cache();
+
+        // Returns the reflected method tables for the JVM the current 
+        // thread is attached to.
+        method_table_cache& get_method_tables();
+
+        // Returns the cache of interned java.lang.String objects for the 
+        // JVM the current thread is attached to.
+        string_cache& get_string_cache();
+
+        // Returns the registry of C++ exception types for the JVM the 
+        // current thread is attached to.
+        exception_registry& get_exception_registry();
+
+        // Throws the Java exception pending on the thread as a C++ 
+        // exception, of the type registered for its class if there is one.
+        // The exception is left pending in the JVM.
+        [[noreturn]] void throw_pending_exception(JNIEnv* env);
+
     }
 
     // The functions in this namespace are exception-throwing wrappers 
@@ -71,37 +172,94 @@ namespace java
     // for further information.
     namespace jni
     {
+        // Error policies for the templated field and array wrappers below,
+        // which are the ones that end up in tight loops.  The policy is the
+        // last template argument, e.g., get_field<jint, jni::deferred>.
+        //
+        // checked (the default) throws as soon as a call fails.  deferred 
+        // skips the JNI exception check after each call and leaves the 
+        // first failure to be reported by a java::deferred_scope at the end
+        // of the sequence.  The JVM keeps the first Java exception pending 
+        // by itself; calls made while it is pending are undefined 
+        // behaviour per the JNI spec, so only defer calls that are 
+        // expected to succeed (e.g., reading fields, or array regions 
+        // whose bounds have been checked).  A call that returns a null 
+        // pointer still throws under deferred, since the caller would 
+        // otherwise use it.  unchecked trusts the caller completely, and 
+        // reduces each wrapper to the bare JNIEnv call. It only does so in
+        // release (NDEBUG) builds, and behaves like checked otherwise.
+        struct checked
+        {
+            static void check(JNIEnv* env) { if (env->ExceptionCheck()) internal::throw_pending_exception(env); }
+            static void check_result(const void* result, const char* error) { if (result == nullptr) throw std::exception(error); }
+        };
+
+        struct deferred
+        {
+            static void check(JNIEnv*) {}
+            static void check_result(const void* result, const char* error) { if (result == nullptr) throw std::exception(error); }
+        };
+
+#ifdef NDEBUG
+        struct unchecked
+        {
+            static void check(JNIEnv*) {}
+            static void check_result(const void*, const char*) {}
+        };
+#else
+        struct unchecked : checked {};
+#endif
 
         jclass define_class(const char* name, jbyte* data, jsize size);
 
 #ifdef DEBUG_REFS
         extern std::list<jobject> _refs;
 #endif
+        jobject new_local_ref(jobject obj);
+        jobject new_global_ref(jobject obj);
         void delete_local_ref(jobject obj);
         void delete_global_ref(jobject obj);
+        jweak new_weak_global_ref(jobject obj);
+        void delete_weak_global_ref(jweak obj);
 
         jfieldID get_field_id(jclass cls, const char* name, const char* sig);
 
         jfieldID get_static_field_id(jclass cls, const char* name, const char* sig);
 
-        template <typename jtype>
+        template <typename jtype, typename policy = checked>
         jtype get_field(jobject obj, jfieldID id)
         {
             auto env = internal::get_env();
             auto ret = type_traits<jtype>::get_field(env, obj, id);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            policy::check(env);
             return ret;
         };
 
-        template <typename jtype>
-        jtype get_static_field(jobject obj, jfieldID id)
+        template <typename jtype, typename policy = checked>
+        jtype get_static_field(jclass cls, jfieldID id)
         {
             auto env = internal::get_env();
-            auto ret = type_traits<jtype>::get_static_field(env, obj, id);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            auto ret = type_traits<jtype>::get_static_field(env, cls, id);
+            policy::check(env);
             return ret;
         };
 
+        template <typename jtype, typename policy = checked>
+        void set_field(jobject obj, jfieldID id, jtype value)
+        {
+            auto env = internal::get_env();
+            type_traits<jtype>::set_field(env, obj, id, value);
+            policy::check(env);
+        };
+
+        template <typename jtype, typename policy = checked>
+        void set_static_field(jclass cls, jfieldID id, jtype value)
+        {
+            auto env = internal::get_env();
+            type_traits<jtype>::set_static_field(env, cls, id, value);
+            policy::check(env);
+        };
+
         jclass find_class(const char* name);
 
         jclass get_object_class(jobject obj);
@@ -112,38 +270,94 @@ namespace java
 
         jsize get_array_length(jarray a);
         
-        template <typename jtype>
+        template <typename jtype, typename policy = checked>
         jtype* get_array_elements(typename type_traits<jtype>::array_type arr, jboolean* isCopy)
         {
             auto env = internal::get_env();
-            auto ptr = type_traits<jtype>::get_array_elements(env, arr, nullptr);
-            if (ptr == nullptr) throw std::exception("Get<type>ArrayElements failed");
+            auto ptr = type_traits<jtype>::get_array_elements(env, arr, isCopy);
+            policy::check_result(ptr, "Get<type>ArrayElements failed");
             return ptr;
         }
 
-        template <typename jtype>
+        template <typename jtype, typename policy = checked>
         void release_array_elements(typename type_traits<jtype>::array_type arr, jtype* ptr, int mode)
         {
             auto env = internal::get_env();
-            auto fptr = type_traits<jtype>::release_array_elements;
             type_traits<jtype>::release_array_elements(env, arr, ptr, mode);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            policy::check(env);
         }
 
+        // Copies len elements, starting at index start, out of a Java 
+        // primitive array into buf.
+        template <typename jtype, typename policy = checked>
+        void get_array_region(typename type_traits<jtype>::array_type arr, jsize start, jsize len, jtype* buf)
+        {
+            auto env = internal::get_env();
+            type_traits<jtype>::get_array_region(env, arr, start, len, buf);
+            policy::check(env);
+        }
+
+        // Copies len elements from buf into a Java primitive array, starting
+        // at index start.
+        template <typename jtype, typename policy = checked>
+        void set_array_region(typename type_traits<jtype>::array_type arr, jsize start, jsize len, const jtype* buf)
+        {
+            auto env = internal::get_env();
+            type_traits<jtype>::set_array_region(env, arr, start, len, buf);
+            policy::check(env);
+        }
+
+        void* get_primitive_array_critical(jarray a, jboolean* isCopy);
+
+        void release_primitive_array_critical(jarray a, void* ptr, jint mode);
+
         jobject get_object_array_element(jobjectArray a, jsize i);
 
+        jobject new_direct_byte_buffer(void* address, jlong capacity);
+
+        void* get_direct_buffer_address(jobject buf);
+
+        jlong get_direct_buffer_capacity(jobject buf);
+
         void set_object_array_element(jobjectArray a, jsize i, jobject value);
 
         jstring new_string_utf(const char* data);
 
+        jstring new_string(const jchar* chars, jsize len);
+
+        // Creates a string from standard UTF-8, which unlike the modified 
+        // UTF-8 taken by new_string_utf() may contain NULs and four-byte
+        // sequences.
+        jstring new_string_utf8(const char* data, size_t len);
+
         const char* get_string_utf_chars(jstring jstr);
 
         void release_string_utf_chars(jstring jstr, const char* data);
 
+        // The number of UTF-16 code units in the string.
+        jsize get_string_length(jstring jstr);
+
+        // The number of bytes needed to hold the string in modified UTF-8,
+        // not counting a terminating NUL.
+        jsize get_string_utf_length(jstring jstr);
+
+        // These copy len characters starting at start into a buffer owned by
+        // the caller, without the JVM allocating anything.  The UTF version
+        // writes modified UTF-8 followed by a NUL, so buf must hold 
+        // get_string_utf_length() + 1 bytes for the whole string.
+        void get_string_region(jstring jstr, jsize start, jsize len, jchar* buf);
+        void get_string_utf_region(jstring jstr, jsize start, jsize len, char* buf);
+
+        const jchar* get_string_critical(jstring jstr, jboolean* is_copy);
+
+        void release_string_critical(jstring jstr, const jchar* data);
+
         jobject allocate_object(jclass cls);
 
         jobject new_object(jclass cls, jmethodID ctor, ...);
 
+        jobject new_objecta(jclass cls, jmethodID ctor, const jvalue* args);
+
         jobjectArray new_object_array(jclass cls, jsize length, jobject initial);
 
         bool is_assignable_from(jclass src, jclass target);
@@ -159,7 +373,7 @@ namespace java
             va_list args;
             va_start(args, method);
             auto ret = type_traits<jtype>::call_static_methodv(env, cls, method, args);
-            if (env->ExceptionOccurred()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             va_end(args);
             return ret;
         }
@@ -171,7 +385,7 @@ namespace java
         {
             auto env = internal::get_env();
             auto ret = type_traits<jtype>::call_static_methodv(env, cls, method, args);
-            if (env->ExceptionOccurred()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             return ret;
         }
         template <>
@@ -184,7 +398,7 @@ namespace java
             va_list args;
             va_start(args, method);
             auto ret = type_traits<jtype>::call_methodv(env, obj, method, args);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             va_end(args);
             return ret;
         }
@@ -196,66 +410,245 @@ namespace java
         {
             auto env = internal::get_env();
             auto ret = type_traits<jtype>::call_methodv(env, obj, method, args);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             return ret;
         }
         template <>
         void call_methodv<void>(jobject obj, jmethodID method, va_list args);
 
+        template <typename jtype>
+        jtype call_static_methoda(jclass cls, jmethodID method, const jvalue* args)
+        {
+            auto env = internal::get_env();
+            auto ret = type_traits<jtype>::call_static_methoda(env, cls, method, args);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+            return ret;
+        }
+        template <>
+        void call_static_methoda<void>(jclass cls, jmethodID method, const jvalue* args);
+
+        template <typename jtype>
+        jtype call_methoda(jobject obj, jmethodID method, const jvalue* args)
+        {
+            auto env = internal::get_env();
+            auto ret = type_traits<jtype>::call_methoda(env, obj, method, args);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+            return ret;
+        }
+        template <>
+        void call_methoda<void>(jobject obj, jmethodID method, const jvalue* args);
+
         template <typename jtype>
         typename type_traits<jtype>::array_type new_array(size_t i)
         {
             auto env = internal::get_env();
             auto ret = type_traits<jtype>::new_array(env, i);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             return ret;
         }
 
-        // This function converts a Java jstring into a std::string
+        // This function converts a Java jstring into a std::string, encoded
+        // as standard UTF-8.
         std::string jstring_str(jstring jstr);
 
+        // This function converts a Java jstring into UTF-16, which is the
+        // JVM's own representation, so unlike jstring_str() it is lossless.
+        std::u16string jstring_u16str(jstring jstr);
+
 		void register_natives(jclass cls, JNINativeMethod* methods, jint num_methods);
     }
 
-    // This class provides automatic garbage collection for local references 
-    // returned by the JNI.  It is implemented using reference counting 
-    // internally (std::shared_ptr).
+    template <typename jobject_t> class global_ref;
+    template <typename jobject_t> class weak_ref;
+
+    // These classes provide automatic garbage collection for the references
+    // returned by the JNI.  Each one is a single pointer wide and owns its 
+    // reference exclusively, so they can be moved but not copied.  Making 
+    // another reference to the same Java object is always explicit (clone(),
+    // make_global(), make_weak()) since it costs a call into the JVM.
+    //
+    // A local_ref is only valid on the thread that created it, and only 
+    // until the native method that created it returns (or the local_frame 
+    // it was created in is popped).  It deletes the reference when it goes
+    // out of scope.
     template <typename jobject_t>
     class local_ref
     {
-        typedef jobject_t pointer_type;
-        typedef std::shared_ptr<_jobject> shared_ptr_type;
+        jobject_t _ptr;
 
-        shared_ptr_type _ref;
+        local_ref(const local_ref&);
+        local_ref& operator= (const local_ref&);
 
     public:
+        typedef jobject_t pointer_type;
+
+        local_ref() : _ptr(nullptr) {}
+
+        // Takes ownership of a local reference
+        local_ref(jobject native) : _ptr((jobject_t)native) {}
+
+        local_ref(local_ref&& other) : _ptr(other.release()) {}
+
         template <typename t>
-        local_ref(const local_ref<t>& other)
+        local_ref(local_ref<t>&& other) : _ptr((jobject_t)other.release()) {}
+
+        ~local_ref() { reset(); }
+
+        local_ref& operator= (local_ref&& other)
         {
-            _ref = other.ref();
+            if (this != &other) reset(other.release());
+            return *this;
         }
 
-        shared_ptr_type ref() const { return _ref; }
+        jobject_t get() const { return _ptr; }
 
-        local_ref() {}
-
-        local_ref(jobject native) : _ref((pointer_type)native, jni::delete_local_ref) {}
+        // Gives up ownership of the reference without deleting it
+        jobject_t release()
+        {
+            jobject_t ret = _ptr;
+            _ptr = nullptr;
+            return ret;
+        }
 
-        void make_global()
+        void reset(jobject native = nullptr)
         {
-            auto global = internal::get_env()->NewGlobalRef(_ref.get());
-            _ref.reset(global, jni::delete_global_ref);
+            if (_ptr != nullptr) jni::delete_local_ref(_ptr);
+            _ptr = (jobject_t)native;
         }
 
+        // Returns a new local reference to the same Java object
+        local_ref clone() const { return local_ref(_ptr == nullptr ? nullptr : jni::new_local_ref(_ptr)); }
+
+        // Returns a global reference to the same Java object.  This 
+        // reference is left untouched.
+        global_ref<jobject_t> make_global() const;
+
+        // Returns a weak global reference to the same Java object
+        weak_ref<jobject_t> make_weak() const;
+
+        explicit operator bool() const { return _ptr != nullptr; }
+
         template <typename rhs_jobject_t>
-        bool operator== (const local_ref<rhs_jobject_t>& rhs) const { return static_cast<jobject>(_ref.get()) == static_cast<jobject>(rhs._ref.get()); }
+        bool operator== (const local_ref<rhs_jobject_t>& rhs) const { return (jobject)_ptr == (jobject)rhs.get(); }
 
         template <typename rhs_jobject_t>
-        bool operator!= (const local_ref<rhs_jobject_t>& rhs) const { return static_cast<jobject>(_ref.get()) != static_cast<jobject>(rhs._ref.get()); }
+        bool operator!= (const local_ref<rhs_jobject_t>& rhs) const { return (jobject)_ptr != (jobject)rhs.get(); }
+    };
+
+    // A global_ref may be used from any thread attached to the JVM, and 
+    // keeps the Java object alive until it goes out of scope.  Copies have 
+    // to be made explicitly with clone().
+    template <typename jobject_t>
+    class global_ref
+    {
+        jobject_t _ptr;
+
+        global_ref(const global_ref&);
+        global_ref& operator= (const global_ref&);
+
+    public:
+        typedef jobject_t pointer_type;
+
+        global_ref() : _ptr(nullptr) {}
+
+        // Takes ownership of a global reference
+        explicit global_ref(jobject native) : _ptr((jobject_t)native) {}
+
+        global_ref(global_ref&& other) : _ptr(other.release()) {}
+
+        ~global_ref() { reset(); }
+
+        global_ref& operator= (global_ref&& other)
+        {
+            if (this != &other) reset(other.release());
+            return *this;
+        }
+
+        jobject_t get() const { return _ptr; }
+
+        jobject_t release()
+        {
+            jobject_t ret = _ptr;
+            _ptr = nullptr;
+            return ret;
+        }
+
+        void reset(jobject native = nullptr)
+        {
+            if (_ptr != nullptr) jni::delete_global_ref(_ptr);
+            _ptr = (jobject_t)native;
+        }
+
+        // Returns a new global reference to the same Java object
+        global_ref clone() const { return global_ref(_ptr == nullptr ? nullptr : jni::new_global_ref(_ptr)); }
+
+        // Returns a local reference to the same Java object, for use on the
+        // current thread.
+        local_ref<jobject_t> make_local() const { return local_ref<jobject_t>(_ptr == nullptr ? nullptr : jni::new_local_ref(_ptr)); }
+
+        explicit operator bool() const { return _ptr != nullptr; }
+    };
+
+    // A weak_ref may be used from any thread attached to the JVM, but 
+    // doesn't keep the Java object alive.  Use lock() to get a strong 
+    // reference before using the object; it returns a null local_ref once
+    // the object has been garbage collected.
+    template <typename jobject_t>
+    class weak_ref
+    {
+        jweak _ptr;
 
-        pointer_type get() const { return (pointer_type)_ref.get(); }
+        weak_ref(const weak_ref&);
+        weak_ref& operator= (const weak_ref&);
+
+    public:
+        weak_ref() : _ptr(nullptr) {}
+
+        // Takes ownership of a weak global reference
+        explicit weak_ref(jweak native) : _ptr(native) {}
+
+        weak_ref(weak_ref&& other) : _ptr(other._ptr) { other._ptr = nullptr; }
+
+        ~weak_ref() { reset(); }
+
+        weak_ref& operator= (weak_ref&& other)
+        {
+            if (this != &other)
+            {
+                reset(other._ptr);
+                other._ptr = nullptr;
+            }
+            return *this;
+        }
+
+        jweak get() const { return _ptr; }
+
+        void reset(jweak native = nullptr)
+        {
+            if (_ptr != nullptr) jni::delete_weak_global_ref(_ptr);
+            _ptr = native;
+        }
+
+        // Returns a local reference to the object, or a null reference if 
+        // it has been garbage collected.
+        local_ref<jobject_t> lock() const { return local_ref<jobject_t>(_ptr == nullptr ? nullptr : internal::get_env()->NewLocalRef(_ptr)); }
+
+        // Returns true if the object has been garbage collected
+        bool expired() const { return _ptr == nullptr || internal::get_env()->IsSameObject(_ptr, nullptr) == JNI_TRUE; }
     };
 
+    template <typename jobject_t>
+    global_ref<jobject_t> local_ref<jobject_t>::make_global() const
+    {
+        return global_ref<jobject_t>(_ptr == nullptr ? nullptr : jni::new_global_ref(_ptr));
+    }
+
+    template <typename jobject_t>
+    weak_ref<jobject_t> local_ref<jobject_t>::make_weak() const
+    {
+        return weak_ref<jobject_t>(_ptr == nullptr ? nullptr : jni::new_weak_global_ref(_ptr));
+    }
+
     enum jni_version
     {
 #ifdef JNI_VERSION_1_1
@@ -318,9 +711,15 @@ namespace java
     // a specific version of the JNI library at runtime.  If this function 
     // is not called, the java::vm class looks for the library using the 
     // platform's normal search paths (i.e., it calls LoadLibrary on 
-    // Windows).
+    // Windows, or dlopen for libjvm.so elsewhere).
     void load_jvmdll(const char* path);
 
+#ifdef _WIN32
+#define JAVA_JVM_LIBRARY "jvm.dll"
+#else
+#define JAVA_JVM_LIBRARY "libjvm.so"
+#endif
+
 	namespace internal
 	{
 		
@@ -342,9 +741,16 @@ namespace java
 		internal::vm_context _vm;
         bool _is_owner;
 
+        void release_attach_group()
+        {
+            if (_vm.attach_group == nullptr) return;
+            internal::get_env()->DeleteGlobalRef(_vm.attach_group);
+            _vm.attach_group = nullptr;
+        }
+
         void init(const vm_args& args)
         {
-            if (p_JNI_CreateJavaVM == nullptr) load_jvmdll("jvm.dll");
+            if (p_JNI_CreateJavaVM == nullptr) load_jvmdll(JAVA_JVM_LIBRARY);
 
             JavaVMInitArgs internal_args;
 
@@ -405,40 +811,95 @@ namespace java
         // the vm was constructed using a pre-existing JNIEnv pointer.
         ~vm()
         {
+            disable_auto_attach();
+            _vm.methods.clear();
+            _vm.members.clear();
+            _vm.tables.clear();
+            _vm.strings.clear();
+            _vm.exceptions.clear();
+            _vm.boxing.clear();
+            _vm.classes.clear();
+
             if (_is_owner)
             {
                 _vm.jvm->DestroyJavaVM();
 				internal::delete_thread_context();
+				internal::invalidate_thread_contexts();
             }
         }
 
-        // Attaches the current thread to this JVM.  Make sure to call 
-        // detach_thread to reclaim memory before the thread exits.  This 
-        // does not currently support JavaVMAttachArgs.
+        // Attaches the current thread to this JVM.  If detach_thread isn't
+        // called before the thread exits, the thread is detached (and its
+        // memory reclaimed) during thread exit.  This does not currently 
+        // support JavaVMAttachArgs.
         void attach_thread()
         {
             if (internal::get_tls_value() == nullptr)
             {
+				// A thread the JVM already knows about must not be detached
+				// by the library
+				JNIEnv* env;
+				if (_vm.jvm->GetEnv((void**)&env, jni_1_6) == JNI_OK)
+				{
+					internal::set_thread_context(internal::thread_context(&_vm, env));
+					return;
+				}
+
                 JavaVMAttachArgs args;
                 args.version = jni_1_6;
                 args.name = nullptr;
                 args.group = nullptr;
 
-				JNIEnv* env;
 				if (_vm.jvm->AttachCurrentThread((void**)&env, &args) != JNI_OK)
                     throw std::exception("AttachCurrentThread failed");
 
-				internal::set_thread_context(internal::thread_context(&_vm, env));
+				internal::set_thread_context(internal::thread_context(&_vm, env, true));
             }
         }
 
-        // Detaches the current thread from this JVM, and frees thread-local 
-        // memory.
+        // Detaches the current thread from this JVM, if the library 
+        // attached it, and frees thread-local memory.  Threads the JVM 
+        // already knew about (e.g., a Java thread calling a native method)
+        // stay attached.
         void detach_thread()
         {
-            _vm.jvm->DetachCurrentThread();
+			auto context = reinterpret_cast<internal::thread_context*>(internal::get_tls_value());
+			if (context != nullptr && context->attached) _vm.jvm->DetachCurrentThread();
 			internal::delete_thread_context();
         }
+
+        // Makes threads that aren't attached to any JVM attach to this one
+        // the first time they call into the library, instead of throwing.
+        // They are attached as daemon threads (so they don't keep the JVM
+        // from shutting down), with the given name and thread group (both
+        // optional), and stay attached until they exit or call 
+        // detach_thread.  Once a thread is attached, calls cost the same as
+        // on any other attached thread.  Only one JVM can attach on demand
+        // at a time; this should be called before other threads start 
+        // using the library.
+        //
+        // Threads are detached by the same thread exit hook as threads 
+        // attached with attach_thread.  On Windows with JAVA_NO_THREAD_LOCAL
+        // there is no such hook, and threads must call detach_thread.
+        void enable_auto_attach(const char* thread_name = nullptr, jobject thread_group = nullptr)
+        {
+            release_attach_group();
+            _vm.attach_name = thread_name != nullptr ? thread_name : "";
+            if (thread_group != nullptr)
+            {
+                _vm.attach_group = internal::get_env()->NewGlobalRef(thread_group);
+                if (_vm.attach_group == nullptr) throw std::exception("NewGlobalRef failed");
+            }
+            internal::set_auto_attach_vm(&_vm);
+        }
+
+        // Stops attaching threads to this JVM on demand.  Threads that were
+        // already attached stay attached.
+        void disable_auto_attach()
+        {
+            if (internal::get_auto_attach_vm() == &_vm) internal::set_auto_attach_vm(nullptr);
+            release_attach_group();
+        }
     };
 
     // This class is useful for safely attaching and detaching a thread 
@@ -1,36 +1,72 @@
 
 #include "jvm.h"
 #include "exception.h"
+#include "utf.h"
+#include <atomic>
 
 namespace java
 {
     namespace internal
     {
-        static DWORD tlsIndex = TLS_OUT_OF_INDEXES;
+        static std::atomic<unsigned> vmGeneration(0);
 
-		DWORD get_tls_index()
+        unsigned get_vm_generation()
+        {
+            return vmGeneration.load(std::memory_order_acquire);
+        }
+
+        void invalidate_thread_contexts()
+        {
+            vmGeneration.fetch_add(1, std::memory_order_acq_rel);
+        }
+
+        // Detaches the thread from the JVM if the library attached it (and
+        // the JVM still exists), and frees the thread's context.  This is 
+        // called during thread exit.
+        static void release_thread_context(void* value)
         {
-            // Allocate the TLS slot, if it hasn't been done already.  This 
-            // should happen only once, and all threads use the same slot.
-            if (tlsIndex == TLS_OUT_OF_INDEXES &&
-                (tlsIndex = ::TlsAlloc()) == TLS_OUT_OF_INDEXES)
+            thread_context* context = reinterpret_cast<thread_context*>(value);
+            if (context == nullptr) return;
+            if (context->attached && context->generation == get_vm_generation()) context->jvm->DetachCurrentThread();
+            delete context;
+        }
+
+#ifdef _WIN32
+        // The TLS slot is allocated by a function-local static, whose 
+        // initialization is thread-safe, since executor threads and threads
+        // attached on demand can get here at the same time.  All threads 
+        // use the same slot.
+        struct tls_slot
+        {
+            DWORD index;
+
+            tls_slot() : index(::TlsAlloc())
             {
-                throw std::exception("TlsAlloc failed");
+                if (index == TLS_OUT_OF_INDEXES) throw std::exception("TlsAlloc failed");
             }
+        };
 
-            return tlsIndex;
+        static tls_slot& get_tls_slot_index()
+        {
+            static tls_slot slot;
+            return slot;
         }
 
-        void free_tls_index()
+		DWORD get_tls_index()
         {
-            auto index = get_tls_index();
+            return get_tls_slot_index().index;
+        }
 
-            ::TlsFree(index);
+        void free_tls_index()
+        {
+            auto& slot = get_tls_slot_index();
+            if (slot.index == TLS_OUT_OF_INDEXES) return;
 
-            tlsIndex = TLS_OUT_OF_INDEXES;
+            ::TlsFree(slot.index);
+            slot.index = TLS_OUT_OF_INDEXES;
         }
 
-        LPVOID get_tls_value()
+        static void* get_tls_slot()
         {
             LPVOID value = ::TlsGetValue(get_tls_index());
             if (value == 0 && ::GetLastError() != ERROR_SUCCESS)
@@ -38,7 +74,7 @@ namespace java
             return value;
         }
 
-        void set_tls_value(LPVOID value)
+        static void set_tls_slot(void* value)
         {
             if (::TlsSetValue(get_tls_index(), value) == FALSE)
             {
@@ -46,18 +82,161 @@ namespace java
                 throw std::exception("TlsGetValue failed");
             }
         }
+#else
+        // The key is created by a function-local static, whose 
+        // initialization is thread-safe, since executor threads and threads
+        // attached on demand can get here at the same time.  The key's 
+        // destructor runs for each exiting thread that still has a context,
+        // which detaches it from the JVM.
+        struct tls_key
+        {
+            pthread_key_t key;
+            bool allocated;
+
+            tls_key() : allocated(false)
+            {
+                if (::pthread_key_create(&key, release_thread_context) != 0)
+                    throw std::exception("pthread_key_create failed");
+                allocated = true;
+            }
+        };
+
+        static tls_key& get_tls_key()
+        {
+            static tls_key key;
+            return key;
+        }
+
+        pthread_key_t get_tls_index()
+        {
+            return get_tls_key().key;
+        }
+
+        void free_tls_index()
+        {
+            auto& key = get_tls_key();
+            if (key.allocated)
+            {
+                ::pthread_key_delete(key.key);
+                key.allocated = false;
+            }
+        }
+
+        static void* get_tls_slot()
+        {
+            return ::pthread_getspecific(get_tls_index());
+        }
+
+        static void set_tls_slot(void* value)
+        {
+            if (::pthread_setspecific(get_tls_index(), value) != 0)
+                throw std::exception("pthread_setspecific failed");
+        }
+#endif
+
+#ifndef JAVA_NO_THREAD_LOCAL
+        static thread_local thread_context* tlsContext = nullptr;
+
+#ifdef _WIN32
+        // Windows has no thread exit callback short of DllMain, so a 
+        // thread_local object's destructor is used to detach the thread.
+        struct thread_exit_hook
+        {
+            ~thread_exit_hook()
+            {
+                release_thread_context(tlsContext);
+                tlsContext = nullptr;
+            }
+        };
+
+        static thread_local thread_exit_hook tlsExitHook;
+#endif
+
+        void* get_tls_value()
+        {
+            return tlsContext;
+        }
+
+        void set_tls_value(void* value)
+        {
+            tlsContext = reinterpret_cast<thread_context*>(value);
+#ifdef _WIN32
+            // Make sure the hook is constructed, so its destructor runs
+            (void)&tlsExitHook;
+#else
+            set_tls_slot(value);
+#endif
+        }
+#else
+        void* get_tls_value()
+        {
+            return get_tls_slot();
+        }
+
+        void set_tls_value(void* value)
+        {
+            set_tls_slot(value);
+        }
+#endif
+
+        static std::atomic<vm_context*> autoAttachVm(nullptr);
+
+        void set_auto_attach_vm(vm_context* vm)
+        {
+            autoAttachVm.store(vm, std::memory_order_release);
+        }
+
+        vm_context* get_auto_attach_vm()
+        {
+            return autoAttachVm.load(std::memory_order_acquire);
+        }
+
+        // The slow path of get_thread_context, taken once per thread.  A 
+        // thread that is already attached (e.g., a Java thread calling a 
+        // native method) just gets a context.  Otherwise the context is 
+        // marked as attached by the library, so the thread exit hook 
+        // detaches the thread.
+        static thread_context& attach_on_demand()
+        {
+            vm_context* vm = get_auto_attach_vm();
+            if (vm == nullptr) throw std::exception("Thread not attached to the JVM");
+
+            JNIEnv* env;
+            jint status = vm->jvm->GetEnv((void**)&env, jni_1_6);
+            if (status == JNI_OK)
+            {
+                set_thread_context(thread_context(vm, env));
+                return *reinterpret_cast<thread_context*>(get_tls_value());
+            }
+            if (status != JNI_EDETACHED) throw std::exception("GetEnv failed");
+
+            JavaVMAttachArgs args;
+            args.version = jni_1_6;
+            args.name = vm->attach_name.empty() ? nullptr : const_cast<char*>(vm->attach_name.c_str());
+            args.group = vm->attach_group;
+
+            if (vm->jvm->AttachCurrentThreadAsDaemon((void**)&env, &args) != JNI_OK)
+                throw std::exception("AttachCurrentThreadAsDaemon failed");
+
+            set_thread_context(thread_context(vm, env, true));
+            return *reinterpret_cast<thread_context*>(get_tls_value());
+        }
 
 		thread_context& get_thread_context()
 		{
 			thread_context* context = reinterpret_cast<thread_context*>(get_tls_value());
-			if (context == nullptr) throw std::exception("Thread not attached to the JVM");
+			if (context == nullptr) return attach_on_demand();
 			return *context;
 		}
 
 		void delete_thread_context()
 		{
 			thread_context* context = reinterpret_cast<thread_context*>(get_tls_value());
-			if (context != nullptr) delete context;
+			if (context != nullptr)
+			{
+				set_tls_value(nullptr);
+				delete context;
+			}
 		}
 
 		void set_thread_context(const thread_context& context)
@@ -71,16 +250,64 @@ namespace java
 			return get_thread_context().env;
         }
 
+        bool in_local_frame()
+        {
+			thread_context* context = reinterpret_cast<thread_context*>(get_tls_value());
+            return context != nullptr && context->frame_depth > 0;
+        }
+
+        method_cache& get_method_cache()
+        {
+            return get_thread_context().vm->methods;
+        }
+
+        member_cache& get_member_cache()
+        {
+            return get_thread_context().vm->members;
+        }
+
+        class_registry& get_class_registry()
+        {
+            return get_thread_context().vm->classes;
+        }
+
+        boxing_cache& get_boxing_cache()
+        {
+            return get_thread_context().vm->boxing;
+        }
+
+        method_table_cache& get_method_tables()
+        {
+            return get_thread_context().vm->tables;
+        }
+
+        string_cache& get_string_cache()
+        {
+            return get_thread_context().vm->strings;
+        }
+
+        exception_registry& get_exception_registry()
+        {
+            return get_thread_context().vm->exceptions;
+        }
+
     }
 
     JNI_CreateJavaVM_type p_JNI_CreateJavaVM = nullptr;
 
     void load_jvmdll(const char* path)
     {
+#ifdef _WIN32
         auto module = ::LoadLibraryA(path);
         if (module == NULL) throw std::exception("Failed to load jvm.dll");
 
         p_JNI_CreateJavaVM = (JNI_CreateJavaVM_type)::GetProcAddress(module, "JNI_CreateJavaVM");
+#else
+        auto module = ::dlopen(path, RTLD_NOW | RTLD_GLOBAL);
+        if (module == nullptr) throw std::exception("Failed to load libjvm.so");
+
+        p_JNI_CreateJavaVM = (JNI_CreateJavaVM_type)::dlsym(module, "JNI_CreateJavaVM");
+#endif
         if (p_JNI_CreateJavaVM == nullptr) throw std::exception("Failed to initialize JVM library");
     }
 
@@ -90,13 +317,30 @@ namespace java
         {
             auto env = internal::get_env();
             jclass ret = env->DefineClass(name, loader, data, size);
-            if (env->ExceptionOccurred()) throw java::exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             return ret;
         }
 
 #ifdef DEBUG_REFS
         std::list<jobject> _refs;
 #endif
+        jobject new_local_ref(jobject obj)
+        {
+            auto ret = internal::get_env()->NewLocalRef(obj);
+            if (ret == nullptr && obj != nullptr) throw std::exception("NewLocalRef failed");
+#ifdef DEBUG_REFS
+            _refs.push_back(ret);
+#endif
+            return ret;
+        }
+
+        jobject new_global_ref(jobject obj)
+        {
+            auto ret = internal::get_env()->NewGlobalRef(obj);
+            if (ret == nullptr && obj != nullptr) throw std::exception("NewGlobalRef failed");
+            return ret;
+        }
+
         void delete_local_ref(jobject obj)
         {
             auto env = internal::get_env();
@@ -115,6 +359,18 @@ namespace java
 #endif
         }
 
+        jweak new_weak_global_ref(jobject obj)
+        {
+            auto ret = internal::get_env()->NewWeakGlobalRef(obj);
+            if (ret == nullptr && obj != nullptr) throw std::exception("NewWeakGlobalRef failed");
+            return ret;
+        }
+
+        void delete_weak_global_ref(jweak obj)
+        {
+            internal::get_env()->DeleteWeakGlobalRef(obj);
+        }
+
         template <>
         void call_static_method<void>(jclass cls, jmethodID method, ...)
         {
@@ -122,7 +378,7 @@ namespace java
             va_list args;
             va_start(args, method);
             type_traits<void>::call_static_methodv(env, cls, method, args);
-            if (env->ExceptionOccurred()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             va_end(args);
         }
         
@@ -131,7 +387,7 @@ namespace java
         {
             auto env = internal::get_env();
             type_traits<void>::call_static_methodv(env, cls, method, args);
-            if (env->ExceptionOccurred()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
         }
 
         template <>
@@ -141,7 +397,7 @@ namespace java
             va_list args;
             va_start(args, method);
             type_traits<void>::call_methodv(env, obj, method, args);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
             va_end(args);
         }
 
@@ -150,7 +406,23 @@ namespace java
         {
             auto env = internal::get_env();
             type_traits<void>::call_methodv(env, obj, method, args);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+        }
+
+        template <>
+        void call_static_methoda<void>(jclass cls, jmethodID method, const jvalue* args)
+        {
+            auto env = internal::get_env();
+            type_traits<void>::call_static_methoda(env, cls, method, args);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+        }
+
+        template <>
+        void call_methoda<void>(jobject obj, jmethodID method, const jvalue* args)
+        {
+            auto env = internal::get_env();
+            type_traits<void>::call_methoda(env, obj, method, args);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
         }
 
         jclass find_class(const char* name)
@@ -192,6 +464,18 @@ namespace java
             return internal::get_env()->GetArrayLength(a);
         }
 
+        void* get_primitive_array_critical(jarray a, jboolean* isCopy)
+        {
+            auto ptr = internal::get_env()->GetPrimitiveArrayCritical(a, isCopy);
+            if (ptr == nullptr) throw std::exception("GetPrimitiveArrayCritical failed");
+            return ptr;
+        }
+
+        void release_primitive_array_critical(jarray a, void* ptr, jint mode)
+        {
+            internal::get_env()->ReleasePrimitiveArrayCritical(a, ptr, mode);
+        }
+
         jobject get_object_array_element(jobjectArray a, jsize i)
         {
             auto obj = internal::get_env()->GetObjectArrayElement(a, i);
@@ -202,11 +486,37 @@ namespace java
             return obj;
         }
 
+        jobject new_direct_byte_buffer(void* address, jlong capacity)
+        {
+            auto env = internal::get_env();
+            auto buf = env->NewDirectByteBuffer(address, capacity);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+            if (buf == nullptr) throw std::exception("NewDirectByteBuffer failed");
+#ifdef DEBUG_REFS
+            _refs.push_back(buf);
+#endif
+            return buf;
+        }
+
+        void* get_direct_buffer_address(jobject buf)
+        {
+            auto address = internal::get_env()->GetDirectBufferAddress(buf);
+            if (address == nullptr) throw std::exception("GetDirectBufferAddress failed");
+            return address;
+        }
+
+        jlong get_direct_buffer_capacity(jobject buf)
+        {
+            auto capacity = internal::get_env()->GetDirectBufferCapacity(buf);
+            if (capacity < 0) throw std::exception("GetDirectBufferCapacity failed");
+            return capacity;
+        }
+
         void set_object_array_element(jobjectArray a, jsize i, jobject value)
         {
             auto env = internal::get_env();
             env->SetObjectArrayElement(a, i, value);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
         }
 
         jstring new_string_utf(const char* data)
@@ -219,6 +529,30 @@ namespace java
             return jstr;
         }
 
+        jstring new_string(const jchar* chars, jsize len)
+        {
+            jstring jstr = internal::get_env()->NewString(chars, len);
+            if (jstr == nullptr) throw std::exception("NewString failed");
+#ifdef DEBUG_REFS
+            _refs.push_back(jstr);
+#endif
+            return jstr;
+        }
+
+        jstring new_string_utf8(const char* data, size_t len)
+        {
+            const size_t small_size = 256;
+
+            if (len <= small_size)
+            {
+                jchar buf[small_size];
+                return new_string(buf, (jsize)utf::utf8_to_utf16(data, len, buf));
+            }
+
+            std::vector<jchar> buf(utf::max_utf16_length(len));
+            return new_string(buf.data(), (jsize)utf::utf8_to_utf16(data, len, buf.data()));
+        }
+
         const char* get_string_utf_chars(jstring jstr)
         {
             auto data = internal::get_env()->GetStringUTFChars(jstr, nullptr);
@@ -231,6 +565,42 @@ namespace java
             internal::get_env()->ReleaseStringUTFChars(jstr, data);
         }
 
+        jsize get_string_length(jstring jstr)
+        {
+            return internal::get_env()->GetStringLength(jstr);
+        }
+
+        jsize get_string_utf_length(jstring jstr)
+        {
+            return internal::get_env()->GetStringUTFLength(jstr);
+        }
+
+        void get_string_region(jstring jstr, jsize start, jsize len, jchar* buf)
+        {
+            auto env = internal::get_env();
+            env->GetStringRegion(jstr, start, len, buf);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+        }
+
+        void get_string_utf_region(jstring jstr, jsize start, jsize len, char* buf)
+        {
+            auto env = internal::get_env();
+            env->GetStringUTFRegion(jstr, start, len, buf);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+        }
+
+        const jchar* get_string_critical(jstring jstr, jboolean* is_copy)
+        {
+            auto data = internal::get_env()->GetStringCritical(jstr, is_copy);
+            if (data == nullptr) throw std::exception("GetStringCritical failed");
+            return data;
+        }
+
+        void release_string_critical(jstring jstr, const jchar* data)
+        {
+            internal::get_env()->ReleaseStringCritical(jstr, data);
+        }
+
         jobject allocate_object(jclass cls)
         {
             jobject obj = internal::get_env()->AllocObject(cls);
@@ -248,7 +618,18 @@ namespace java
             auto env = internal::get_env();
             auto obj = env->NewObjectV(cls, ctor, args);
             va_end(args);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
+#ifdef DEBUG_REFS
+            _refs.push_back(obj);
+#endif
+            return obj;
+        }
+
+        jobject new_objecta(jclass cls, jmethodID ctor, const jvalue* args)
+        {
+            auto env = internal::get_env();
+            auto obj = env->NewObjectA(cls, ctor, args);
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
 #ifdef DEBUG_REFS
             _refs.push_back(obj);
 #endif
@@ -259,7 +640,7 @@ namespace java
         {
             auto env = internal::get_env();
             auto ret = env->NewObjectArray(length, cls, initial);
-            if (env->ExceptionCheck()) throw exception(env->ExceptionOccurred());
+            if (env->ExceptionCheck()) internal::throw_pending_exception(env);
 #ifdef DEBUG_REFS
             _refs.push_back(ret);
 #endif
@@ -288,12 +669,37 @@ namespace java
             return method;
         }
 
-        // This function converts a Java jstring into a std::string
+        // This function converts a Java jstring into a std::string.  Short
+        // strings are copied onto the stack with GetStringRegion, and long
+        // ones are transcoded straight out of the JVM's storage inside a 
+        // critical region, so the JVM never allocates a buffer that then 
+        // has to be copied again.
         std::string jstring_str(jstring jstr)
         {
-            auto data = jni::get_string_utf_chars(jstr);
-            std::string ret(data);
-            jni::release_string_utf_chars(jstr, data);
+            const jsize small_size = 256;
+
+            auto len = get_string_length(jstr);
+            if (len <= small_size)
+            {
+                jchar chars[small_size];
+                char buf[small_size * 3];
+                get_string_region(jstr, 0, len, chars);
+                return std::string(buf, utf::utf16_to_utf8(chars, len, buf));
+            }
+
+            std::string ret(utf::max_utf8_length(len), '\0');
+            auto chars = get_string_critical(jstr, nullptr);
+            auto size = utf::utf16_to_utf8(chars, len, &ret[0]);
+            release_string_critical(jstr, chars);
+            ret.resize(size);
+            return ret;
+        }
+
+        std::u16string jstring_u16str(jstring jstr)
+        {
+            std::u16string ret(get_string_length(jstr), u'\0');
+            if (!ret.empty())
+                get_string_region(jstr, 0, (jsize)ret.size(), reinterpret_cast<jchar*>(&ret[0]));
             return ret;
         }
 
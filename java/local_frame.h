@@ -0,0 +1,49 @@
+#pragma once
+
+#include "java\object.h"
+
+namespace java
+{
+    // This class pushes a JNI local reference frame for the duration of a
+    // scope.  Every local reference created in the frame is freed in one
+    // go when the frame is popped, instead of one DeleteLocalRef call per
+    // reference.  While a frame is active, java::object values created in
+    // it borrow their local references instead of deleting them, which 
+    // makes them much cheaper to create and destroy in tight loops.
+    //
+    // The flip side is that objects created inside the frame must not be
+    // used after it is popped.  To return a value from the frame, pass it
+    // to pop(), which moves it into the enclosing frame, or call
+    // make_global() on it.  Frames must be popped in the reverse order
+    // they were pushed, on the thread that pushed them.
+    class local_frame
+    {
+        bool _popped;
+
+        local_frame(const local_frame&);
+        local_frame& operator= (const local_frame&);
+
+    public:
+        // Pushes a frame with room for at least the given number of local
+        // references.  Throws an exception if the JVM is out of memory.
+        explicit local_frame(jint capacity = 16);
+
+        // Pops the frame if it hasn't already been popped.
+        ~local_frame();
+
+        // Makes sure at least the given number of local references can be
+        // created in the frame.  Throws an exception if the JVM is out of
+        // memory.
+        void ensure(jint capacity);
+
+        // Pops the frame, freeing all local references created in it.
+        void pop();
+
+        // Pops the frame, freeing all local references created in it
+        // except for the one held by result, which is moved into the
+        // enclosing frame.  The returned object holds the new reference.
+        object pop(const object& result);
+
+        bool popped() const { return _popped; }
+    };
+}
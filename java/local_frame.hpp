@@ -0,0 +1,48 @@
+#include "local_frame.h"
+#include "jvm.h"
+
+namespace java
+{
+    local_frame::local_frame(jint capacity)
+        : _popped(false)
+    {
+        auto env = internal::get_env();
+        if (env->PushLocalFrame(capacity) < 0)
+            internal::throw_pending_exception(env);
+
+        internal::get_thread_context().frame_depth++;
+    }
+
+    local_frame::~local_frame()
+    {
+        if (!_popped) pop();
+    }
+
+    void local_frame::ensure(jint capacity)
+    {
+        auto env = internal::get_env();
+        if (env->EnsureLocalCapacity(capacity) < 0)
+            internal::throw_pending_exception(env);
+    }
+
+    void local_frame::pop()
+    {
+        if (_popped) throw std::exception("Local frame already popped");
+
+        _popped = true;
+        internal::get_thread_context().frame_depth--;
+        internal::get_env()->PopLocalFrame(nullptr);
+    }
+
+    object local_frame::pop(const object& result)
+    {
+        if (_popped) throw std::exception("Local frame already popped");
+        if (!result.is_ref()) { pop(); return result.clone(); }
+
+        // The depth is updated first, so that the returned object owns (and
+        // deletes) its reference if there's no enclosing frame.
+        _popped = true;
+        internal::get_thread_context().frame_depth--;
+        return object(internal::get_env()->PopLocalFrame(result.native()));
+    }
+}
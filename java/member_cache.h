@@ -0,0 +1,138 @@
+#pragma once
+
+#include "jni.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace java
+{
+    namespace internal
+    {
+        enum member_kind
+        {
+            instance_method,
+            static_method,
+            instance_field,
+            static_field
+        };
+
+        class member_cache;
+
+        // A small memo of resolved methods, kept by each instantiation of 
+        // the typed call templates (as a function-local static), so it is
+        // shared by every call with the same signature.  A repeat call 
+        // finds its method ID by comparing the name and checking the 
+        // target's class, without hashing the name and descriptor.  Names
+        // are copied and compared by content, since callers may pass 
+        // runtime strings.  A site remembers at most max_entries methods;
+        // other calls go through the member_cache as usual.
+        class member_site
+        {
+            friend class member_cache;
+
+            static const size_t max_entries = 8;
+
+            struct entry
+            {
+                std::string name;
+                jclass cls;
+                jmethodID method;
+                entry* next;
+            };
+
+            std::atomic<entry*> _entries;
+            std::atomic<bool> _registered;
+
+            member_site(const member_site&);
+            member_site& operator= (const member_site&);
+
+        public:
+            member_site() : _entries(nullptr), _registered(false) {}
+        };
+
+        // This class caches method and field ID's that are resolved from an 
+        // explicit name and JNI type descriptor (e.g., 
+        // "(ILjava/lang/String;)J"), rather than through reflection.  
+        // Entries are keyed by the kind of member, the name, the descriptor
+        // and the class the ID was resolved against.  An instance method 
+        // matches any object that is an instance of the cached class, since
+        // JNI dispatches through the ID virtually.  Fields and static 
+        // methods only match the same class, since a subclass may hide a 
+        // field of the same name.
+        //
+        // Like method_cache, readers never take a lock.  Entries are 
+        // immutable once published, and are only freed by clear().
+        class member_cache
+        {
+            static const size_t bucket_count = 512;
+
+            struct entry
+            {
+                size_t hash;
+                member_kind kind;
+                std::string name;
+                std::string descriptor;
+                jclass cls;
+                jmethodID method;
+                jfieldID field;
+                entry* next;
+            };
+
+            std::atomic<entry*> _buckets[bucket_count];
+
+            // The call sites that hold entries for this JVM, so that clear()
+            // can release them.
+            std::mutex _sites_lock;
+            std::vector<member_site*> _sites;
+
+            static size_t hash(member_kind kind, const char* name, const char* descriptor);
+
+            const entry* find(jobject target, member_kind kind, const char* name, const char* descriptor);
+
+            void insert(entry* e);
+
+            // Looks up a public field through java.lang.Class.getField, for
+            // reference fields whose exact type isn't known.  Returns null 
+            // if there's no such reference field.
+            static jfieldID get_reflected_field(jclass cls, member_kind kind, const char* name);
+
+            member_cache(const member_cache&);
+            member_cache& operator= (const member_cache&);
+
+        public:
+            member_cache();
+            ~member_cache();
+
+            // Returns the ID of a method with the given name and descriptor.
+            // The target is the object the method will be called on for 
+            // instance methods, or the class for static methods.  Throws 
+            // nosuchmethod_exception if there is no such method.
+            jmethodID get_method(jobject target, member_kind kind, const char* name, const char* descriptor);
+
+            // Does the same through a site's memo, which is checked first 
+            // and updated on a miss.
+            jmethodID get_method(member_site& site, jobject target, member_kind kind, const char* name, const char* descriptor);
+
+            // Returns the ID of a field with the given name and descriptor.
+            // The target is the object holding the field for instance 
+            // fields, or the class for static fields.  A descriptor of 
+            // "Ljava/lang/Object;" matches a public field of any reference 
+            // type.  Throws nosuchfield_exception if there is no such field,
+            // or an exception if the target is null.
+            jfieldID get_field(jobject target, member_kind kind, const char* name, const char* descriptor);
+
+            // Does the same for a field of the class itself, which for 
+            // instance fields is then valid for any instance of the class.  
+            // If cached_class isn't null, it receives the cache's global 
+            // reference to the class, which stays valid for the lifetime of
+            // the JVM.
+            jfieldID resolve_field(jclass cls, member_kind kind, const char* name, const char* descriptor, jclass* cached_class = nullptr);
+
+            // Deletes all entries, including those of call sites, and the 
+            // global references they hold.
+            void clear();
+        };
+    }
+}
@@ -0,0 +1,259 @@
+
+#include "member_cache.h"
+#include "nosuchmethod_exception.h"
+#include "nosuchfield_exception.h"
+#include "jvm.h"
+#include <cstring>
+
+namespace java
+{
+    namespace internal
+    {
+        member_cache::member_cache()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+                _buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        member_cache::~member_cache()
+        {
+            // Only the memory is released here, since the JVM may already 
+            // be gone.  Call clear() beforehand to release the global 
+            // references.
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        size_t member_cache::hash(member_kind kind, const char* name, const char* descriptor)
+        {
+            size_t h = 2166136261u;
+            h = (h ^ (size_t)kind) * 16777619u;
+            for (const char* c = name; *c != '\0'; c++)
+                h = (h ^ (unsigned char)*c) * 16777619u;
+            for (const char* c = descriptor; *c != '\0'; c++)
+                h = (h ^ (unsigned char)*c) * 16777619u;
+            return h;
+        }
+
+        const member_cache::entry* member_cache::find(jobject target, member_kind kind, const char* name, const char* descriptor)
+        {
+            auto env = get_env();
+            auto h = hash(kind, name, descriptor);
+
+            for (entry* e = _buckets[h % bucket_count].load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (e->hash != h || e->kind != kind || e->name != name || e->descriptor != descriptor)
+                    continue;
+
+                bool match = kind == instance_method
+                    ? env->IsInstanceOf(target, e->cls) == JNI_TRUE
+                    : env->IsSameObject(e->cls, target) == JNI_TRUE;
+
+                if (match) return e;
+            }
+
+            return nullptr;
+        }
+
+        void member_cache::insert(entry* e)
+        {
+            auto& bucket = _buckets[e->hash % bucket_count];
+            e->next = bucket.load(std::memory_order_relaxed);
+            while (!bucket.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+        }
+
+        jmethodID member_cache::get_method(jobject target, member_kind kind, const char* name, const char* descriptor)
+        {
+            auto cached = find(target, kind, name, descriptor);
+            if (cached != nullptr) return cached->method;
+
+            auto env = get_env();
+            clazz cls(kind == static_method
+                ? (jclass)jni::new_local_ref(target)
+                : jni::get_object_class(target));
+
+            auto id = kind == static_method
+                ? env->GetStaticMethodID(cls.native(), name, descriptor)
+                : env->GetMethodID(cls.native(), name, descriptor);
+
+            if (id == nullptr)
+            {
+                // Don't leave the NoSuchMethodError pending in the JVM
+                env->ExceptionClear();
+                throw nosuchmethod_exception(cls, name, descriptor);
+            }
+
+            entry* e = new entry();
+            e->hash = hash(kind, name, descriptor);
+            e->kind = kind;
+            e->name = name;
+            e->descriptor = descriptor;
+            e->cls = (jclass)jni::new_global_ref(cls.native());
+            e->method = id;
+            e->field = nullptr;
+            insert(e);
+
+            return id;
+        }
+
+        jmethodID member_cache::get_method(member_site& site, jobject target, member_kind kind, const char* name, const char* descriptor)
+        {
+            auto env = get_env();
+            size_t count = 0;
+            for (auto e = site._entries.load(std::memory_order_acquire); e != nullptr; e = e->next, count++)
+            {
+                if (e->name != name) continue;
+
+                bool match = kind == instance_method
+                    ? env->IsInstanceOf(target, e->cls) == JNI_TRUE
+                    : e->cls == target || env->IsSameObject(e->cls, target) == JNI_TRUE;
+
+                if (match) return e->method;
+            }
+
+            auto id = get_method(target, kind, name, descriptor);
+            if (count >= member_site::max_entries) return id;
+
+            auto e = new member_site::entry();
+            e->name = name;
+            e->cls = kind == instance_method
+                ? (jclass)jni::new_global_ref(local_ref<jclass>(jni::get_object_class(target)).get())
+                : (jclass)jni::new_global_ref(target);
+            e->method = id;
+
+            e->next = site._entries.load(std::memory_order_relaxed);
+            while (!site._entries.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            if (!site._registered.exchange(true))
+            {
+                std::lock_guard<std::mutex> lock(_sites_lock);
+                _sites.push_back(&site);
+            }
+
+            return id;
+        }
+
+        jfieldID member_cache::get_field(jobject target, member_kind kind, const char* name, const char* descriptor)
+        {
+            if (target == nullptr) throw std::exception("Field accessed on a null reference");
+
+            // Instance fields are keyed by the object's exact class
+            if (kind == static_field) return resolve_field((jclass)target, kind, name, descriptor);
+
+            local_ref<jclass> object_class = jni::get_object_class(target);
+            return resolve_field(object_class.get(), kind, name, descriptor);
+        }
+
+        jfieldID member_cache::resolve_field(jclass cls, member_kind kind, const char* name, const char* descriptor, jclass* cached_class)
+        {
+            auto cached = find(cls, kind, name, descriptor);
+            if (cached != nullptr)
+            {
+                if (cached_class != nullptr) *cached_class = cached->cls;
+                return cached->field;
+            }
+
+            auto env = get_env();
+            auto id = kind == static_field
+                ? env->GetStaticFieldID(cls, name, descriptor)
+                : env->GetFieldID(cls, name, descriptor);
+
+            if (id == nullptr)
+            {
+                // Don't leave the NoSuchFieldError pending in the JVM
+                env->ExceptionClear();
+
+                if (strcmp(descriptor, "Ljava/lang/Object;") == 0)
+                    id = get_reflected_field(cls, kind, name);
+
+                if (id == nullptr)
+                    throw nosuchfield_exception(clazz(object::borrow(cls)), name, descriptor);
+            }
+
+            entry* e = new entry();
+            e->hash = hash(kind, name, descriptor);
+            e->kind = kind;
+            e->name = name;
+            e->descriptor = descriptor;
+            e->cls = (jclass)jni::new_global_ref(cls);
+            e->method = nullptr;
+            e->field = id;
+            insert(e);
+
+            if (cached_class != nullptr) *cached_class = e->cls;
+            return id;
+        }
+
+        jfieldID member_cache::get_reflected_field(jclass cls, member_kind kind, const char* name)
+        {
+            const jint static_modifier = 0x0008;
+            auto env = get_env();
+
+            jclass class_class = get_class_registry().find("java/lang/Class");
+            auto getField = jni::get_method_id(class_class, "getField", "(Ljava/lang/String;)Ljava/lang/reflect/Field;");
+            local_ref<jstring> jname = jni::new_string_utf(name);
+
+            local_ref<jobject> field = env->CallObjectMethod(cls, getField, jname.get());
+            if (env->ExceptionCheck())
+            {
+                env->ExceptionClear();
+                return nullptr;
+            }
+
+            local_ref<jclass> field_class = jni::get_object_class(field.get());
+            auto getType = jni::get_method_id(field_class.get(), "getType", "()Ljava/lang/Class;");
+            auto getModifiers = jni::get_method_id(field_class.get(), "getModifiers", "()I");
+            auto isPrimitive = jni::get_method_id(class_class, "isPrimitive", "()Z");
+
+            local_ref<jobject> type = jni::call_method<jobject>(field.get(), getType);
+            if (jni::call_method<jboolean>(type.get(), isPrimitive)) return nullptr;
+
+            bool is_static = (jni::call_method<jint>(field.get(), getModifiers) & static_modifier) != 0;
+            if (is_static != (kind == static_field)) return nullptr;
+
+            return env->FromReflectedField(field.get());
+        }
+
+        void member_cache::clear()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_sites_lock);
+                for (auto it = _sites.begin(); it != _sites.end(); it++)
+                {
+                    auto e = (*it)->_entries.exchange(nullptr);
+                    while (e != nullptr)
+                    {
+                        auto next = e->next;
+                        jni::delete_global_ref(e->cls);
+                        delete e;
+                        e = next;
+                    }
+                    (*it)->_registered.store(false);
+                }
+                _sites.clear();
+            }
+
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+                    jni::delete_global_ref(e->cls);
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "jvm.h"
+#include "method_table.h"
 #include <vector>
 
 namespace java
@@ -8,17 +9,48 @@ namespace java
     class clazz;
 
     // This class encapsulates a Java method, either static or non-static.  
-    // Reflection is used to gather method details from the JVM.
+    // Methods obtained from a class's method table answer questions about
+    // themselves from the table; otherwise reflection is used to gather 
+    // method details from the JVM.
     class method
     {
         jmethodID _id;
         local_ref<jobject> _methodObj;
+        const internal::method_table* _table;
+        size_t _index;
+
+        // The JNI types of the return value and parameters.  These are 
+        // filled in once, either from the method cache or on first use, so
+        // that invoking the method doesn't need to go through reflection.
+        mutable bool _kinds_resolved;
+        mutable jni::value_type _return_kind;
+        mutable std::vector<jni::value_type> _param_kinds;
+
+        void resolve_kinds() const;
 
     public:
         method();
         
+        // Takes ownership of a local reference to a java.lang.reflect.Method
+        // (or Constructor) object.
         method(local_ref<jobject> methodObj);
 
+        // Creates a method from a cached lookup result.  This doesn't need 
+        // to go through reflection, other than taking a new local reference
+        // to the cached java.lang.reflect.Method object.
+        method(const internal::resolved_method& resolved);
+
+        // Creates a method from entry i of a method table.  The table must
+        // outlive the method.
+        method(const internal::method_table& table, size_t i);
+
+        // Copying a method takes a new local reference to the reflected 
+        // method object.
+        method(const method& other);
+        method(method&& other);
+        method& operator= (const method& rhs);
+        method& operator= (method&& rhs);
+
         // Returns the native JVM jmethodID for this method
         jmethodID id() { return _id; }
 
@@ -39,26 +71,42 @@ namespace java
         // contents of the string match what the java.lang.Class.getName() 
         // method returns.
         std::string return_type();
+
+        // Returns the JNI type returned by the method.  Constructors are 
+        // considered to return void.
+        jni::value_type return_kind() const;
+
+        // Returns the JNI types of the method's parameters.
+        const std::vector<jni::value_type>& param_kinds() const;
+
+        // Returns the Java language modifiers for the method, as returned by
+        // java.lang.reflect.Method.getModifiers().
+        jint modifiers() const;
+
+        // Returns the reflected java.lang.reflect.Method object.  The 
+        // reference is owned by the method.
+        jobject native() const { return _methodObj.get(); }
     };
 
     // This class is used to iterate methods of a Java class by wrapping an 
-    // index into a Java java.lang.reflect.Method[] array.
+    // index into the class's method table.  The method at the current 
+    // index is only created when the iterator is dereferenced.
     class method_iterator : public std::iterator<std::forward_iterator_tag, method>
     {
-        local_ref<jclass> _class;
-        local_ref<jobjectArray> _methods;
-        jsize _index;
+        const internal::method_table* _table;
+        size_t _index;
+        size_t _current_index;
         method _current;
 
     public:
-        method_iterator(local_ref<jclass> cls, local_ref<jobjectArray> methods, jsize i)
-            : _class(cls), _methods(methods), _index(i), _current()
+        method_iterator(const internal::method_table* table, size_t i)
+            : _table(table), _index(i), _current_index(internal::method_table::npos), _current()
         {
         }
 
         bool operator== (const method_iterator& rhs)
         {
-            return _methods == rhs._methods && _index == rhs._index;
+            return _table == rhs._table && _index == rhs._index;
         }
 
         bool operator!= (const method_iterator& rhs) { return !this->operator==(rhs); }
@@ -97,16 +145,18 @@ namespace java
         }
     };
 
-    // This class encapsulates a list of methods for a class, obtained via 
-    // reflection by wrapping a java.lang.reflect.Method[] array.
+    // This class encapsulates a list of methods for a class, backed by the
+    // class's method table.  The table is owned by the per-VM cache, so 
+    // the list is cheap to copy.
     class method_list
     {
-        local_ref<jclass> _class;
-        local_ref<jobjectArray> _methods;
-        jsize _size;
+        const internal::method_table* _table;
+        size_t _size;
 
     public:
-        method_list(local_ref<jclass> cls, local_ref<jobjectArray> methods);
+        method_list(const internal::method_table& table);
+
+        size_t size() const { return _size; }
 
         method_iterator begin();
 
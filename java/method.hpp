@@ -6,17 +6,67 @@
 namespace java
 {
 	method::method()
-		: _id(nullptr), _methodObj()
+		: _id(nullptr), _methodObj(), _table(nullptr), _index(0), _kinds_resolved(false), _return_kind(jni::void_value)
 	{
 	}
 
 	method::method(local_ref<jobject> methodObj)
-		: _id(jni::from_reflected_method(methodObj.get())), _methodObj(methodObj)
+		: _id(jni::from_reflected_method(methodObj.get())), _methodObj(std::move(methodObj)), _table(nullptr), _index(0),
+		_kinds_resolved(false), _return_kind(jni::void_value)
 	{
 	}
 
+	method::method(const internal::resolved_method& resolved)
+		: _id(resolved.id), _methodObj(jni::new_local_ref(resolved.method_obj)), _table(resolved.table), _index(resolved.index),
+		_kinds_resolved(true), _return_kind(resolved.return_kind), _param_kinds(resolved.param_kinds)
+	{
+	}
+
+	method::method(const internal::method_table& table, size_t i)
+		: _id(table.ids[i]), _methodObj(jni::new_local_ref(table.method_objs[i])), _table(&table), _index(i),
+		_kinds_resolved(true), _return_kind(table.return_kinds[i]),
+		_param_kinds(table.param_kinds.begin() + table.param_begin[i], table.param_kinds.begin() + table.param_begin[i + 1])
+	{
+	}
+
+	method::method(const method& other)
+		: _id(other._id), _methodObj(other._methodObj.clone()), _table(other._table), _index(other._index),
+		_kinds_resolved(other._kinds_resolved), _return_kind(other._return_kind), _param_kinds(other._param_kinds)
+	{
+	}
+
+	method::method(method&& other)
+		: _id(other._id), _methodObj(std::move(other._methodObj)), _table(other._table), _index(other._index),
+		_kinds_resolved(other._kinds_resolved), _return_kind(other._return_kind), _param_kinds(std::move(other._param_kinds))
+	{
+	}
+
+	method& method::operator= (const method& rhs)
+	{
+		if (this != &rhs)
+		{
+			method tmp(rhs);
+			*this = std::move(tmp);
+		}
+		return *this;
+	}
+
+	method& method::operator= (method&& rhs)
+	{
+		_id = rhs._id;
+		_methodObj = std::move(rhs._methodObj);
+		_table = rhs._table;
+		_index = rhs._index;
+		_kinds_resolved = rhs._kinds_resolved;
+		_return_kind = rhs._return_kind;
+		_param_kinds = std::move(rhs._param_kinds);
+		return *this;
+	}
+
 	std::string method::name() const
 	{
+		if (_table != nullptr) return _table->names[_index];
+
 		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
 		auto getName = jni::get_method_id(method_class.get(), "getName", "()Ljava/lang/String;");
 		local_ref<jstring> name = jni::call_method<jobject>(_methodObj.get(), getName);
@@ -25,6 +75,8 @@ namespace java
 
 	jsize method::num_args()
 	{
+		if (_table != nullptr) return (jsize)_table->num_args(_index);
+
 		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
 		auto getParameterTypes = jni::get_method_id(method_class.get(), "getParameterTypes", "()[Ljava/lang/Class;");
 		local_ref<jobjectArray> parameter_types = jni::call_method<jobject>(_methodObj.get(), getParameterTypes);
@@ -33,6 +85,14 @@ namespace java
 
 	bool method::is_args_assignable(const std::vector<clazz>& classes) const
 	{
+		if (_table != nullptr)
+		{
+			std::vector<jclass> natives;
+			for (auto it = classes.begin(); it != classes.end(); it++)
+				natives.push_back(it->native());
+			return _table->is_args_assignable(_index, natives.data(), natives.size());
+		}
+
 		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
 		auto getParameterTypes = jni::get_method_id(method_class.get(), "getParameterTypes", "()[Ljava/lang/Class;");
 		local_ref<jobjectArray> parameter_types = (jobjectArray)jni::call_method<jobject>(_methodObj.get(), getParameterTypes);
@@ -52,6 +112,8 @@ namespace java
 
 	std::string method::return_type()
 	{
+		if (_table != nullptr) return _table->return_types[_index];
+
 		// Get the return type in order to know which JNI function to call
 		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
 		auto getReturnType = jni::get_method_id(method_class.get(), "getReturnType", "()Ljava/lang/Class;");
@@ -63,17 +125,76 @@ namespace java
 		return jstring_str(jstr.get());
 	}
 
+	void method::resolve_kinds() const
+	{
+		if (_kinds_resolved) return;
+
+		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
+		local_ref<jclass> class_class = jni::find_class("java/lang/Class");
+		auto getName = jni::get_method_id(class_class.get(), "getName", "()Ljava/lang/String;");
+
+		// java.lang.reflect.Constructor doesn't have a return type
+		local_ref<jclass> ctor_class = jni::find_class("java/lang/reflect/Constructor");
+		if (internal::get_env()->IsInstanceOf(_methodObj.get(), ctor_class.get()))
+		{
+			_return_kind = jni::void_value;
+		}
+		else
+		{
+			auto getReturnType = jni::get_method_id(method_class.get(), "getReturnType", "()Ljava/lang/Class;");
+			local_ref<jobject> return_type = jni::call_method<jobject>(_methodObj.get(), getReturnType);
+			local_ref<jstring> name = jni::call_method<jobject>(return_type.get(), getName);
+			_return_kind = internal::value_type_from_name(jstring_str(name.get()));
+		}
+
+		auto getParameterTypes = jni::get_method_id(method_class.get(), "getParameterTypes", "()[Ljava/lang/Class;");
+		local_ref<jobjectArray> parameter_types = jni::call_method<jobject>(_methodObj.get(), getParameterTypes);
+		auto num_args = jni::get_array_length(parameter_types.get());
+
+		_param_kinds.clear();
+		for (jsize i = 0; i < num_args; i++)
+		{
+			local_ref<jobject> type = jni::get_object_array_element(parameter_types.get(), i);
+			local_ref<jstring> name = jni::call_method<jobject>(type.get(), getName);
+			_param_kinds.push_back(internal::value_type_from_name(jstring_str(name.get())));
+		}
+
+		_kinds_resolved = true;
+	}
+
+	jni::value_type method::return_kind() const
+	{
+		resolve_kinds();
+		return _return_kind;
+	}
+
+	const std::vector<jni::value_type>& method::param_kinds() const
+	{
+		resolve_kinds();
+		return _param_kinds;
+	}
+
+	jint method::modifiers() const
+	{
+		if (_table != nullptr) return _table->modifiers[_index];
+
+		local_ref<jclass> method_class = jni::get_object_class(_methodObj.get());
+		auto getModifiers = jni::get_method_id(method_class.get(), "getModifiers", "()I");
+		return jni::call_method<jint>(_methodObj.get(), getModifiers);
+	}
+
 	void method_iterator::get()
 	{
-		_current = method(jni::get_object_array_element((jobjectArray)_methods.get(), _index));
+		if (_current_index == _index) return;
+		_current = method(*_table, _index);
+		_current_index = _index;
 	}
 
-	method_list::method_list(local_ref<jclass> cls, local_ref<jobjectArray> methods) : _class(cls), _methods(methods)
+	method_list::method_list(const internal::method_table& table) : _table(&table), _size(table.size())
 	{
-		_size = jni::get_array_length(_methods.get());
 	}
 
-	method_iterator method_list::begin() { return method_iterator(_class, _methods, 0); }
+	method_iterator method_list::begin() { return method_iterator(_table, 0); }
 
-	method_iterator method_list::end() { return method_iterator(_class, _methods, _size); }
+	method_iterator method_list::end() { return method_iterator(_table, _size); }
 }
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "jni.h"
+#include "java\type_traits.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace java
+{
+    namespace internal
+    {
+        struct method_table;
+
+        // The outcome of resolving a method name and a set of argument
+        // classes against a Java class.  A null id records a failed lookup,
+        // so that repeated misses don't have to walk the reflected methods
+        // again.  The method object is a global reference to the
+        // java.lang.reflect.Method (or Constructor) that was matched, and 
+        // table/index locate the method in its class's method_table.
+        struct resolved_method
+        {
+            jmethodID id;
+            jobject method_obj;
+            jni::value_type return_kind;
+            std::vector<jni::value_type> param_kinds;
+            bool is_static;
+            const method_table* table;
+            size_t index;
+
+            resolved_method()
+                : id(nullptr), method_obj(nullptr), return_kind(jni::void_value), is_static(false), table(nullptr), index(0) {}
+        };
+
+        // This class caches the results of clazz::lookup_method and
+        // clazz::lookup_constructor, keyed by the class, the method name and
+        // the classes of the arguments.  The classes are held as global
+        // references, so entries may be shared by every thread attached to
+        // the JVM.
+        //
+        // Readers never take a lock.  The table is a fixed array of bucket
+        // chains, and entries are immutable once they have been published by
+        // an atomic push onto the front of a chain.  Two threads resolving
+        // the same method at the same time may both insert an entry, which
+        // is harmless since lookups just return the first match.  Entries
+        // are only freed by clear(), which must not run concurrently with
+        // any other access (the java::vm destructor calls it).
+        class method_cache
+        {
+            static const size_t bucket_count = 1024;
+
+            struct entry
+            {
+                size_t hash;
+                jclass cls;
+                std::string name;
+                std::vector<jclass> arg_classes;
+                resolved_method result;
+                entry* next;
+            };
+
+            std::atomic<entry*> _buckets[bucket_count];
+
+            // java.lang.System.identityHashCode, used to hash classes.
+            // Global references can't be compared by address, so lookups
+            // hash the class identity and then confirm with IsSameObject.
+            std::atomic<jclass> _system_class;
+            std::atomic<jmethodID> _identity_hash;
+
+            size_t hash(jclass cls, const char* name, size_t num_args);
+
+            method_cache(const method_cache&);
+            method_cache& operator= (const method_cache&);
+
+        public:
+            method_cache();
+            ~method_cache();
+
+            // Returns the cached result for the given key, or nullptr if the
+            // method hasn't been resolved yet.  Null argument classes (e.g.,
+            // for null references) are part of the key.
+            const resolved_method* find(jclass cls, const char* name, const jclass* arg_classes, size_t num_args);
+
+            // Records the result of a lookup.  The cache takes global
+            // references to the classes, and takes ownership of the global
+            // method_obj reference in the result.
+            const resolved_method& insert(jclass cls, const char* name, const jclass* arg_classes, size_t num_args, const resolved_method& result);
+
+            // Deletes all entries and the global references they hold.
+            void clear();
+        };
+    }
+}
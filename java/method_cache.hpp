@@ -0,0 +1,125 @@
+
+#include "method_cache.h"
+#include "jvm.h"
+
+namespace java
+{
+    namespace internal
+    {
+        method_cache::method_cache()
+            : _system_class(nullptr), _identity_hash(nullptr)
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+                _buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        method_cache::~method_cache()
+        {
+            // The JVM may already be gone at this point, so only the memory
+            // is released here.  Call clear() beforehand to release the
+            // global references.
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        size_t method_cache::hash(jclass cls, const char* name, size_t num_args)
+        {
+            auto env = get_env();
+
+            jclass system = _system_class.load(std::memory_order_acquire);
+            if (system == nullptr)
+            {
+                local_ref<jclass> local = jni::find_class("java/lang/System");
+                _identity_hash.store(jni::get_static_method_id(local.get(), "identityHashCode", "(Ljava/lang/Object;)I"));
+
+                jclass global = (jclass)env->NewGlobalRef(local.get());
+                if (!_system_class.compare_exchange_strong(system, global))
+                    jni::delete_global_ref(global);
+                system = _system_class.load(std::memory_order_acquire);
+            }
+
+            // FNV-1a over the name, seeded with the class identity and the
+            // number of arguments.
+            size_t h = 2166136261u;
+            h = (h ^ (size_t)(unsigned)jni::call_static_method<jint>(system, _identity_hash.load(), cls)) * 16777619u;
+            h = (h ^ num_args) * 16777619u;
+            for (const char* c = name; *c != '\0'; c++)
+                h = (h ^ (unsigned char)*c) * 16777619u;
+            return h;
+        }
+
+        const resolved_method* method_cache::find(jclass cls, const char* name, const jclass* arg_classes, size_t num_args)
+        {
+            auto env = get_env();
+            auto h = hash(cls, name, num_args);
+
+            for (entry* e = _buckets[h % bucket_count].load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (e->hash != h || e->arg_classes.size() != num_args || e->name != name)
+                    continue;
+
+                if (!env->IsSameObject(e->cls, cls))
+                    continue;
+
+                size_t i = 0;
+                while (i < num_args && env->IsSameObject(e->arg_classes[i], arg_classes[i]))
+                    i++;
+
+                if (i == num_args) return &e->result;
+            }
+
+            return nullptr;
+        }
+
+        const resolved_method& method_cache::insert(jclass cls, const char* name, const jclass* arg_classes, size_t num_args, const resolved_method& result)
+        {
+            auto env = get_env();
+
+            entry* e = new entry();
+            e->hash = hash(cls, name, num_args);
+            e->cls = (jclass)env->NewGlobalRef(cls);
+            e->name = name;
+            for (size_t i = 0; i < num_args; i++)
+                e->arg_classes.push_back(arg_classes[i] == nullptr ? nullptr : (jclass)env->NewGlobalRef(arg_classes[i]));
+            e->result = result;
+
+            auto& bucket = _buckets[e->hash % bucket_count];
+            e->next = bucket.load(std::memory_order_relaxed);
+            while (!bucket.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            return e->result;
+        }
+
+        void method_cache::clear()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+
+                    jni::delete_global_ref(e->cls);
+                    for (auto it = e->arg_classes.begin(); it != e->arg_classes.end(); it++)
+                        if (*it != nullptr) jni::delete_global_ref(*it);
+                    if (e->result.method_obj != nullptr) jni::delete_global_ref(e->result.method_obj);
+
+                    delete e;
+                    e = next;
+                }
+            }
+
+            jclass system = _system_class.exchange(nullptr);
+            if (system != nullptr) jni::delete_global_ref(system);
+        }
+    }
+}
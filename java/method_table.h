@@ -0,0 +1,112 @@
+#pragma once
+
+#include "jni.h"
+#include "java\type_traits.h"
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace java
+{
+    namespace internal
+    {
+        // An immutable snapshot of the public methods (or constructors) of a
+        // class, as returned by java.lang.Class.getMethods() or 
+        // getConstructors().  Everything reflection would be asked about a
+        // method is gathered in a single pass when the table is built, so 
+        // that naming, listing and overload resolution can run against 
+        // plain C++ data afterwards.
+        //
+        // The data is stored as parallel arrays (one element per method), 
+        // sorted by the hash of the method name so that all overloads of a
+        // name are adjacent.  Methods with the same name keep the order 
+        // reflection returned them in.  Parameter data is flattened into a
+        // single array, with param_begin giving each method's range.  The
+        // classes and reflected method objects are global references, 
+        // released by release().
+        struct method_table
+        {
+            static const size_t npos = (size_t)-1;
+
+            bool constructors;
+
+            std::vector<size_t> name_hashes;
+            std::vector<std::string> names;
+            std::vector<jmethodID> ids;
+            std::vector<jobject> method_objs;
+            std::vector<jint> modifiers;
+            std::vector<jni::value_type> return_kinds;
+            std::vector<std::string> return_types;
+
+            std::vector<size_t> param_begin;
+            std::vector<jclass> param_classes;
+            std::vector<jni::value_type> param_kinds;
+
+            size_t size() const { return ids.size(); }
+
+            size_t num_args(size_t i) const { return param_begin[i + 1] - param_begin[i]; }
+
+            bool is_static(size_t i) const { return (modifiers[i] & 0x0008) != 0; }
+
+            // Returns the range of indices of the methods with the given 
+            // name.  The name is ignored for constructor tables.
+            std::pair<size_t, size_t> find(const char* name) const;
+
+            // Checks whether arguments of the given classes can be passed to
+            // method i.  A null class is considered assignable to any 
+            // reference parameter.
+            bool is_args_assignable(size_t i, const jclass* arg_classes, size_t num_args) const;
+
+            // Returns the index of the first method with the given name 
+            // that accepts the arguments, or npos if there is none.
+            size_t resolve(const char* name, const jclass* arg_classes, size_t num_args) const;
+
+            // Reflects over the class and builds its table.
+            static method_table* build(jclass cls, bool constructors);
+
+            static size_t hash(const char* name);
+
+            // Deletes the global references held by the table.
+            void release();
+        };
+
+        // Maps a name returned by java.lang.Class.getName() to the JNI type
+        // used to pass or return a value of that type.
+        jni::value_type value_type_from_name(const std::string& name);
+
+        // This class holds the method tables of every class that has been 
+        // reflected over, keyed by the class identity and whether the table
+        // lists constructors.  Like method_cache, readers never take a 
+        // lock.  Tables are built on first use and published with an atomic
+        // push, and are only freed by clear().
+        class method_table_cache
+        {
+            static const size_t bucket_count = 256;
+
+            struct entry
+            {
+                size_t hash;
+                jclass cls;
+                method_table* table;
+                entry* next;
+            };
+
+            std::atomic<entry*> _buckets[bucket_count];
+
+            method_table_cache(const method_table_cache&);
+            method_table_cache& operator= (const method_table_cache&);
+
+        public:
+            method_table_cache();
+            ~method_table_cache();
+
+            // Returns the table for the class, building it if needed.  The
+            // table stays valid until clear() is called.
+            const method_table& get(jclass cls, bool constructors);
+
+            // Deletes all tables and the global references they hold.
+            void clear();
+        };
+    }
+}
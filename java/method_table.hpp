@@ -0,0 +1,289 @@
+
+#include "method_table.h"
+#include "jvm.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace java
+{
+    namespace internal
+    {
+        jni::value_type value_type_from_name(const std::string& name)
+        {
+            if (name == "void") return jni::void_value;
+            else if (name == "boolean") return jni::jboolean_value;
+            else if (name == "byte") return jni::jbyte_value;
+            else if (name == "char") return jni::jchar_value;
+            else if (name == "double") return jni::jdouble_value;
+            else if (name == "float") return jni::jfloat_value;
+            else if (name == "int") return jni::jint_value;
+            else if (name == "long") return jni::jlong_value;
+            else if (name == "short") return jni::jshort_value;
+            else return jni::jobject_value;
+        }
+
+        size_t method_table::hash(const char* name)
+        {
+            size_t h = 2166136261u;
+            for (const char* c = name; *c != '\0'; c++)
+                h = (h ^ (unsigned char)*c) * 16777619u;
+            return h;
+        }
+
+        std::pair<size_t, size_t> method_table::find(const char* name) const
+        {
+            if (constructors) return std::make_pair((size_t)0, size());
+
+            auto h = hash(name);
+            auto range = std::equal_range(name_hashes.begin(), name_hashes.end(), h);
+            return std::make_pair((size_t)(range.first - name_hashes.begin()), (size_t)(range.second - name_hashes.begin()));
+        }
+
+        bool method_table::is_args_assignable(size_t i, const jclass* arg_classes, size_t n) const
+        {
+            if (num_args(i) != n) return false;
+
+            for (size_t j = 0; j < n; j++)
+            {
+                jclass src = arg_classes[j];
+                if (src != nullptr && !jni::is_assignable_from(src, param_classes[param_begin[i] + j]))
+                    return false;
+            }
+
+            return true;
+        }
+
+        size_t method_table::resolve(const char* name, const jclass* arg_classes, size_t n) const
+        {
+            auto range = find(name);
+            for (size_t i = range.first; i < range.second; i++)
+            {
+                if (!constructors && names[i] != name) continue;
+                if (is_args_assignable(i, arg_classes, n)) return i;
+            }
+
+            return npos;
+        }
+
+        method_table* method_table::build(jclass cls, bool constructors)
+        {
+            auto& classes = get_class_registry();
+            jclass class_class = classes.find("java/lang/Class");
+            jclass method_class = classes.find(constructors ? "java/lang/reflect/Constructor" : "java/lang/reflect/Method");
+
+            auto getMethods = constructors
+                ? jni::get_method_id(class_class, "getConstructors", "()[Ljava/lang/reflect/Constructor;")
+                : jni::get_method_id(class_class, "getMethods", "()[Ljava/lang/reflect/Method;");
+            auto getClassName = jni::get_method_id(class_class, "getName", "()Ljava/lang/String;");
+            auto getName = jni::get_method_id(method_class, "getName", "()Ljava/lang/String;");
+            auto getModifiers = jni::get_method_id(method_class, "getModifiers", "()I");
+            auto getParameterTypes = jni::get_method_id(method_class, "getParameterTypes", "()[Ljava/lang/Class;");
+            auto getReturnType = constructors ? nullptr : jni::get_method_id(method_class, "getReturnType", "()Ljava/lang/Class;");
+
+            // Everything is gathered per method first, in reflection order,
+            // and then laid out sorted by name hash.
+            struct record
+            {
+                size_t hash;
+                std::string name;
+                jmethodID id;
+                jobject method_obj;
+                jint modifiers;
+                jni::value_type return_kind;
+                std::string return_type;
+                std::vector<jclass> param_classes;
+                std::vector<jni::value_type> param_kinds;
+            };
+
+            local_ref<jobjectArray> methods = jni::call_method<jobject>(cls, getMethods);
+            jsize count = jni::get_array_length(methods.get());
+            std::vector<record> records(count);
+
+            try
+            {
+                for (jsize i = 0; i < count; i++)
+                {
+                    auto& r = records[i];
+                    local_ref<jobject> m = jni::get_object_array_element(methods.get(), i);
+
+                    r.method_obj = nullptr;
+                    r.id = jni::from_reflected_method(m.get());
+                    r.modifiers = jni::call_method<jint>(m.get(), getModifiers);
+
+                    if (constructors)
+                    {
+                        r.name = "<init>";
+                        r.return_kind = jni::void_value;
+                        r.return_type = "void";
+                    }
+                    else
+                    {
+                        local_ref<jstring> name = jni::call_method<jobject>(m.get(), getName);
+                        r.name = jstring_str(name.get());
+
+                        local_ref<jobject> return_type = jni::call_method<jobject>(m.get(), getReturnType);
+                        local_ref<jstring> return_name = jni::call_method<jobject>(return_type.get(), getClassName);
+                        r.return_type = jstring_str(return_name.get());
+                        r.return_kind = value_type_from_name(r.return_type);
+                    }
+
+                    r.hash = hash(r.name.c_str());
+
+                    local_ref<jobjectArray> params = jni::call_method<jobject>(m.get(), getParameterTypes);
+                    jsize num_params = jni::get_array_length(params.get());
+                    r.param_classes.reserve(num_params);
+                    r.param_kinds.reserve(num_params);
+                    for (jsize j = 0; j < num_params; j++)
+                    {
+                        local_ref<jobject> param = jni::get_object_array_element(params.get(), j);
+                        local_ref<jstring> param_name = jni::call_method<jobject>(param.get(), getClassName);
+                        r.param_kinds.push_back(value_type_from_name(jstring_str(param_name.get())));
+                        r.param_classes.push_back((jclass)jni::new_global_ref(param.get()));
+                    }
+
+                    r.method_obj = jni::new_global_ref(m.get());
+                }
+            }
+            catch (...)
+            {
+                for (auto it = records.begin(); it != records.end(); it++)
+                {
+                    if (it->method_obj != nullptr) jni::delete_global_ref(it->method_obj);
+                    for (auto p = it->param_classes.begin(); p != it->param_classes.end(); p++)
+                        jni::delete_global_ref(*p);
+                }
+                throw;
+            }
+
+            std::vector<size_t> order(records.size());
+            for (size_t i = 0; i < order.size(); i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return records[a].hash < records[b].hash; });
+
+            std::unique_ptr<method_table> table(new method_table());
+            table->constructors = constructors;
+            table->name_hashes.reserve(count);
+            table->names.reserve(count);
+            table->ids.reserve(count);
+            table->method_objs.reserve(count);
+            table->modifiers.reserve(count);
+            table->return_kinds.reserve(count);
+            table->return_types.reserve(count);
+            table->param_begin.reserve(count + 1);
+
+            for (auto it = order.begin(); it != order.end(); it++)
+            {
+                auto& r = records[*it];
+                table->name_hashes.push_back(r.hash);
+                table->names.push_back(std::move(r.name));
+                table->ids.push_back(r.id);
+                table->method_objs.push_back(r.method_obj);
+                table->modifiers.push_back(r.modifiers);
+                table->return_kinds.push_back(r.return_kind);
+                table->return_types.push_back(std::move(r.return_type));
+                table->param_begin.push_back(table->param_classes.size());
+                table->param_classes.insert(table->param_classes.end(), r.param_classes.begin(), r.param_classes.end());
+                table->param_kinds.insert(table->param_kinds.end(), r.param_kinds.begin(), r.param_kinds.end());
+            }
+            table->param_begin.push_back(table->param_classes.size());
+
+            return table.release();
+        }
+
+        void method_table::release()
+        {
+            for (auto it = method_objs.begin(); it != method_objs.end(); it++)
+                jni::delete_global_ref(*it);
+            for (auto it = param_classes.begin(); it != param_classes.end(); it++)
+                jni::delete_global_ref(*it);
+
+            method_objs.clear();
+            param_classes.clear();
+        }
+
+        method_table_cache::method_table_cache()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+                _buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        method_table_cache::~method_table_cache()
+        {
+            // Only the memory is released here, since the JVM may already 
+            // be gone.  Call clear() beforehand to release the global 
+            // references.
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+                    delete e->table;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        const method_table& method_table_cache::get(jclass cls, bool constructors)
+        {
+            auto env = get_env();
+
+            // Classes are hashed by identity, like in method_cache
+            jclass system = get_class_registry().find("java/lang/System");
+            auto identity_hash = get_member_cache().get_method(system, static_method, "identityHashCode", "(Ljava/lang/Object;)I");
+            size_t h = (size_t)(unsigned)jni::call_static_method<jint>(system, identity_hash, cls) * 2 + (constructors ? 1 : 0);
+
+            auto& bucket = _buckets[h % bucket_count];
+            for (entry* e = bucket.load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (e->hash == h && e->table->constructors == constructors && env->IsSameObject(e->cls, cls))
+                    return *e->table;
+            }
+
+            // Two threads may build the same table at the same time, in 
+            // which case both are published and lookups use the first.
+            entry* e = new entry();
+            e->hash = h;
+            e->cls = nullptr;
+            e->table = nullptr;
+            try
+            {
+                e->table = method_table::build(cls, constructors);
+                e->cls = (jclass)jni::new_global_ref(cls);
+            }
+            catch (...)
+            {
+                if (e->table != nullptr) e->table->release();
+                delete e->table;
+                delete e;
+                throw;
+            }
+
+            e->next = bucket.load(std::memory_order_relaxed);
+            while (!bucket.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            return *e->table;
+        }
+
+        void method_table_cache::clear()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                entry* e = _buckets[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    entry* next = e->next;
+
+                    e->table->release();
+                    jni::delete_global_ref(e->cls);
+
+                    delete e->table;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "java\object.h"
+#include "java\signature.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace java
+{
+    namespace internal
+    {
+        // Maps the C++ types a native_implementation handler can take and
+        // return to the JNI types of the generated native methods.  JNI
+        // types are passed through; java::object is passed as a jobject,
+        // and borrows the argument's local reference.
+        template <typename T>
+        struct native_arg
+        {
+            typedef T type;
+            static T from_native(T value) { return value; }
+            static T to_native(JNIEnv*, T value) { return value; }
+        };
+
+        template <>
+        struct native_arg<object>
+        {
+            typedef jobject type;
+            static object from_native(jobject value) { return object::borrow(value); }
+            static jobject to_native(JNIEnv* env, const object& value);
+        };
+
+        template <>
+        struct native_arg<void>
+        {
+            typedef void type;
+        };
+
+        template <typename sig>
+        struct native_signature;
+
+        template <typename R, typename... Args>
+        struct native_signature<R(Args...)>
+        {
+            typedef typename native_arg<R>::type type(typename native_arg<Args>::type...);
+        };
+
+        struct native_method_base
+        {
+            virtual ~native_method_base() {}
+        };
+
+        template <typename sig>
+        struct native_method : native_method_base
+        {
+            std::function<sig> f;
+
+            native_method(std::function<sig> f) : f(std::move(f)) {}
+        };
+
+        // One method of the generated class.  The interface method forwards
+        // its arguments to a static native method named by native_name,
+        // along with the instance's table pointer and the method's index.
+        struct native_method_entry
+        {
+            std::string name;
+            std::string descriptor;
+            std::string native_name;
+            std::string native_descriptor;
+            void* thunk;
+            std::unique_ptr<native_method_base> handler;
+        };
+
+        // The handlers of a native_implementation.  Every instance of the
+        // generated class holds a shared_ptr to the table, which is released
+        // when the instance is finalized.
+        struct native_method_table
+        {
+            std::vector<native_method_entry> methods;
+        };
+
+        // Returns the handler a generated native method was called for.
+        const native_method_base& native_method_at(jlong ptr, jint index);
+
+        // Turns a C++ exception thrown by a handler into a Java exception,
+        // as C++ exceptions must not unwind through JVM frames.  A
+        // java::exception is already pending, and is left as it is.  The 
+        // overload without an exception is for anything that isn't a 
+        // std::exception.
+        void native_method_failed(JNIEnv* env, const std::exception& e);
+        void native_method_failed(JNIEnv* env);
+
+        // The native method bound for each handler signature.  The handler
+        // is found by index, so one instantiation serves every method with
+        // the same signature.
+        template <typename sig>
+        struct native_thunk;
+
+        template <typename R, typename... Args>
+        struct native_thunk<R(Args...)>
+        {
+            static typename native_arg<R>::type JNICALL call(JNIEnv* env, jclass, jlong ptr, jint index, typename native_arg<Args>::type... args)
+            {
+                try
+                {
+                    auto& m = static_cast<const native_method<R(Args...)>&>(native_method_at(ptr, index));
+                    return native_arg<R>::to_native(env, m.f(native_arg<Args>::from_native(args)...));
+                }
+                catch (const std::exception& e)
+                {
+                    native_method_failed(env, e);
+                }
+                catch (...)
+                {
+                    native_method_failed(env);
+                }
+                return typename native_arg<R>::type();
+            }
+        };
+
+        template <typename... Args>
+        struct native_thunk<void(Args...)>
+        {
+            static void JNICALL call(JNIEnv* env, jclass, jlong ptr, jint index, typename native_arg<Args>::type... args)
+            {
+                try
+                {
+                    auto& m = static_cast<const native_method<void(Args...)>&>(native_method_at(ptr, index));
+                    m.f(native_arg<Args>::from_native(args)...);
+                }
+                catch (const std::exception& e)
+                {
+                    native_method_failed(env, e);
+                }
+                catch (...)
+                {
+                    native_method_failed(env);
+                }
+            }
+        };
+    }
+
+    // This class implements a Java interface with C++ functions, by
+    // generating a class whose methods call native methods bound directly
+    // to the handlers.  Unlike create_proxy, there is no
+    // java.lang.reflect.Proxy or InvocationHandler in between: arguments
+    // aren't boxed into an Object[], primitives are passed and returned
+    // as they are, and a call costs about as much as any other call from
+    // Java to a native method.
+    //
+    // Each handler is given with its C++ signature, which uses JNI types
+    // (jint, jobject, jstring, ...) or java::object for references:
+    //
+    //     java::native_implementation cmp("java/util/Comparator");
+    //     cmp.method<jint(java::object, java::object)>("compare",
+    //         [](java::object a, java::object b) -> jint { ... });
+    //     auto comparator = cmp.create();
+    //
+    // The method's descriptor is taken from the C++ signature, which only
+    // works when its reference types are exactly the ones the interface
+    // declares.  Otherwise, give the descriptor after the name, e.g.,
+    // "accept(Ljava/util/Map$Entry;)V"; its primitives must still match
+    // the C++ signature.  Interface methods without a handler throw
+    // AbstractMethodError.
+    //
+    // The class is generated and loaded (through load_class, so the
+    // interface must be visible to the system class loader) by the first
+    // call to create(), after which no more methods can be added.  Objects
+    // created by create() keep the handlers alive after the
+    // native_implementation is destroyed.
+    class native_implementation
+    {
+        std::string _interface_name;
+        std::shared_ptr<internal::native_method_table> _table;
+        std::mutex _mutex;
+        jclass _cls;
+        jmethodID _ctor;
+
+        void add_method(const char* name, const char* native_descriptor, void* thunk, std::unique_ptr<internal::native_method_base> handler);
+        void define();
+
+        native_implementation(const native_implementation&);
+        native_implementation& operator= (const native_implementation&);
+
+    public:
+        // The interface name uses slashes, e.g., "java/lang/Runnable".
+        explicit native_implementation(const char* interface_name);
+
+        // Adds the handler for a method of the interface.  Throws an
+        // exception if the class has already been generated, the method
+        // was already added, the descriptor doesn't match the signature, or
+        // the method has too many parameters to be forwarded (more than 
+        // 252 slots, where long and double take two).
+        template <typename sig, typename F>
+        native_implementation& method(const char* name, F handler)
+        {
+            typedef typename internal::native_signature<sig>::type native_sig;
+
+            std::unique_ptr<internal::native_method_base> m(new internal::native_method<sig>(std::function<sig>(handler)));
+            add_method(name, jni::signature<native_sig>::value, reinterpret_cast<void*>(&internal::native_thunk<sig>::call), std::move(m));
+            return *this;
+        }
+
+        // Creates an instance of the generated class, generating and
+        // loading it first if needed.
+        object create();
+    };
+}
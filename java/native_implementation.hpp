@@ -0,0 +1,298 @@
+
+#include "native_implementation.h"
+#include "class_writer.h"
+#include "clazz.h"
+#include "exception.h"
+#include <atomic>
+#include <cstring>
+
+namespace java
+{
+    namespace internal
+    {
+        namespace
+        {
+            std::atomic<unsigned> nextImplementationNumber(0);
+
+            // Splits a method descriptor into the descriptors of its
+            // parameters and return type.  Returns false if it's malformed.
+            bool split_method_descriptor(const std::string& desc, std::vector<std::string>& params, std::string& ret)
+            {
+                if (desc.empty() || desc[0] != '(') return false;
+
+                size_t i = 1;
+                auto next = [&](std::string& out)
+                {
+                    size_t start = i;
+                    while (i < desc.size() && desc[i] == '[') i++;
+                    if (i >= desc.size() || (desc[i] == 'V' && i > start)) return false;
+
+                    if (desc[i] == 'L')
+                    {
+                        auto end = desc.find(';', i);
+                        if (end == std::string::npos) return false;
+                        i = end + 1;
+                    }
+                    else if (std::strchr("ZBCSIJFDV", desc[i]) != nullptr) i++;
+                    else return false;
+
+                    out = desc.substr(start, i - start);
+                    return true;
+                };
+
+                while (i < desc.size() && desc[i] != ')')
+                {
+                    std::string param;
+                    if (!next(param) || param == "V") return false;
+                    params.push_back(param);
+                }
+
+                if (i++ >= desc.size()) return false;
+                return next(ret) && i == desc.size();
+            }
+
+            bool is_reference_descriptor(const std::string& desc)
+            {
+                return desc[0] == 'L' || desc[0] == '[';
+            }
+
+            // Primitives must match exactly, since they decide how the
+            // native method is called.  Any reference type is a jobject.
+            bool descriptors_compatible(const std::string& declared, const std::string& native)
+            {
+                if (is_reference_descriptor(declared)) return is_reference_descriptor(native);
+                return declared == native;
+            }
+
+            unsigned char load_opcode(char type)
+            {
+                switch (type)
+                {
+                case 'J': return op_lload;
+                case 'F': return op_fload;
+                case 'D': return op_dload;
+                case 'L': case '[': return op_aload;
+                default: return op_iload;
+                }
+            }
+
+            void throw_runtime_exception(JNIEnv* env, const char* message)
+            {
+                jclass cls = env->FindClass("java/lang/RuntimeException");
+                if (cls == nullptr) return;
+                env->ThrowNew(cls, message);
+                env->DeleteLocalRef(cls);
+            }
+
+            unsigned char return_opcode(char type)
+            {
+                switch (type)
+                {
+                case 'V': return op_return;
+                case 'J': return op_lreturn;
+                case 'F': return op_freturn;
+                case 'D': return op_dreturn;
+                case 'L': case '[': return op_areturn;
+                default: return op_ireturn;
+                }
+            }
+
+            void JNICALL finalize_native_implementation(JNIEnv*, jclass, jlong ptr)
+            {
+                delete reinterpret_cast<std::shared_ptr<native_method_table>*>(ptr);
+            }
+        }
+
+        jobject native_arg<object>::to_native(JNIEnv* env, const object& value)
+        {
+            // The handler's object releases its reference when it goes away,
+            // so the JVM needs a reference of its own.
+            return env->NewLocalRef(value.box().native());
+        }
+
+        const native_method_base& native_method_at(jlong ptr, jint index)
+        {
+            auto& table = *reinterpret_cast<std::shared_ptr<native_method_table>*>(ptr);
+            return *table->methods[index].handler;
+        }
+
+        void native_method_failed(JNIEnv* env, const std::exception& e)
+        {
+            if (env->ExceptionCheck()) return;
+
+            // A java::exception that was suspended is thrown again as it is
+            auto ex = dynamic_cast<const exception*>(&e);
+            if (ex != nullptr)
+            {
+                env->Throw((jthrowable)ex->native());
+                return;
+            }
+
+            throw_runtime_exception(env, e.what());
+        }
+
+        void native_method_failed(JNIEnv* env)
+        {
+            if (env->ExceptionCheck()) return;
+            throw_runtime_exception(env, "Unknown C++ exception in native method handler");
+        }
+    }
+
+    native_implementation::native_implementation(const char* interface_name)
+        : _interface_name(interface_name), _table(std::make_shared<internal::native_method_table>()), _cls(nullptr), _ctor(nullptr)
+    {
+    }
+
+    void native_implementation::add_method(const char* name, const char* native_descriptor, void* thunk, std::unique_ptr<internal::native_method_base> handler)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_cls != nullptr) throw std::exception("Methods can't be added after the class is generated");
+
+        std::string method_name(name);
+        std::string descriptor(native_descriptor);
+        auto paren = method_name.find('(');
+        if (paren != std::string::npos)
+        {
+            descriptor = method_name.substr(paren);
+            method_name.erase(paren);
+        }
+        if (method_name.empty()) throw std::exception("Method name is empty");
+
+        std::vector<std::string> params, native_params;
+        std::string ret, native_ret;
+        if (!internal::split_method_descriptor(descriptor, params, ret))
+            throw std::exception("Invalid method descriptor");
+        internal::split_method_descriptor(native_descriptor, native_params, native_ret);
+
+        bool compatible = params.size() == native_params.size() && internal::descriptors_compatible(ret, native_ret);
+        for (size_t i = 0; compatible && i < params.size(); i++)
+            compatible = internal::descriptors_compatible(params[i], native_params[i]);
+        if (!compatible) throw std::exception("Handler signature doesn't match the method descriptor");
+
+        // A method takes at most 255 slots of parameters, and the native 
+        // method adds three (the table pointer and index) to the 
+        // interface method's.  This also keeps every local variable index 
+        // within the one byte the load instructions take.
+        unsigned slots = 3;
+        for (auto it = params.begin(); it != params.end(); it++)
+            slots += (*it == "J" || *it == "D") ? 2 : 1;
+        if (slots > 255) throw std::exception("Method has too many parameters");
+
+        auto& methods = _table->methods;
+        for (auto it = methods.begin(); it != methods.end(); it++)
+        {
+            if (it->name == method_name && it->descriptor == descriptor)
+                throw std::exception("Method already has a handler");
+        }
+
+        // The index is pushed with sipush
+        if (methods.size() > 0x7fff) throw std::exception("Too many methods");
+
+        internal::native_method_entry entry;
+        entry.name = method_name;
+        entry.descriptor = descriptor;
+        entry.native_name = "invoke$" + std::to_string(methods.size());
+        entry.native_descriptor = "(JI" + descriptor.substr(1);
+        entry.thunk = thunk;
+        entry.handler = std::move(handler);
+        methods.push_back(std::move(entry));
+    }
+
+    void native_implementation::define()
+    {
+        using namespace internal;
+
+        std::string name = "proxy/NativeImplementation" + std::to_string(++nextImplementationNumber);
+
+        class_writer writer;
+        writer.add_field(acc_private | acc_final, "ptr", "J");
+        uint16_t ptr_field = writer.field_ref(name, "ptr", "J");
+
+        // public <init>(long ptr) { super(); this.ptr = ptr; }
+        bytecode init;
+        init.op(op_aload_0).op(op_invokespecial).u2(writer.method_ref("java/lang/Object", "<init>", "()V"));
+        init.op(op_aload_0).op(op_lload_1).op(op_putfield).u2(ptr_field);
+        init.op(op_return);
+        init.max_stack = 3;
+        init.max_locals = 3;
+        writer.add_method(acc_public, "<init>", "(J)V", &init);
+
+        // public R name(args) { return invoke$i(this.ptr, i, args); }
+        auto& methods = _table->methods;
+        for (size_t i = 0; i < methods.size(); i++)
+        {
+            auto& m = methods[i];
+            std::vector<std::string> params;
+            std::string ret;
+            split_method_descriptor(m.descriptor, params, ret);
+
+            bytecode code;
+            code.op(op_aload_0).op(op_getfield).u2(ptr_field);
+            code.op(op_sipush).u2((unsigned)i);
+
+            // add_method keeps slot below 256
+            unsigned slot = 1;
+            for (auto p = params.begin(); p != params.end(); p++)
+            {
+                code.op(load_opcode((*p)[0])).u1(slot);
+                slot += ((*p) == "J" || (*p) == "D") ? 2 : 1;
+            }
+
+            code.op(op_invokestatic).u2(writer.method_ref(name, m.native_name, m.native_descriptor));
+            code.op(return_opcode(ret[0]));
+            code.max_locals = (uint16_t)slot;
+            code.max_stack = (uint16_t)(3 + slot - 1);
+
+            writer.add_method(acc_public, m.name, m.descriptor, &code);
+            writer.add_method(acc_private | acc_static | acc_native, m.native_name, m.native_descriptor);
+        }
+
+        // protected void finalize() { finalizeNative(this.ptr); }
+        bytecode finalize;
+        finalize.op(op_aload_0).op(op_getfield).u2(ptr_field);
+        finalize.op(op_invokestatic).u2(writer.method_ref(name, "finalizeNative", "(J)V"));
+        finalize.op(op_return);
+        finalize.max_stack = 2;
+        finalize.max_locals = 1;
+        writer.add_method(acc_protected, "finalize", "()V", &finalize);
+        writer.add_method(acc_private | acc_static | acc_native, "finalizeNative", "(J)V");
+
+        auto data = writer.write(acc_public | acc_final | acc_super, name, "java/lang/Object", std::vector<std::string>(1, _interface_name));
+        auto cls = load_class(name.c_str(), reinterpret_cast<jbyte*>(data.data()), (jsize)data.size());
+
+        std::vector<JNINativeMethod> natives;
+        for (auto it = methods.begin(); it != methods.end(); it++)
+        {
+            JNINativeMethod native;
+            native.name = const_cast<char*>(it->native_name.c_str());
+            native.signature = const_cast<char*>(it->native_descriptor.c_str());
+            native.fnPtr = it->thunk;
+            natives.push_back(native);
+        }
+
+        JNINativeMethod finalize_native;
+        finalize_native.name = const_cast<char*>("finalizeNative");
+        finalize_native.signature = const_cast<char*>("(J)V");
+        finalize_native.fnPtr = reinterpret_cast<void*>(&finalize_native_implementation);
+        natives.push_back(finalize_native);
+
+        jni::register_natives(cls.native(), natives.data(), (jint)natives.size());
+
+        // The class registry keeps the class alive for the life of the vm
+        _ctor = jni::get_method_id(cls.native(), "<init>", "(J)V");
+        _cls = cls.native();
+    }
+
+    object native_implementation::create()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_cls == nullptr) define();
+        }
+
+        std::unique_ptr<std::shared_ptr<internal::native_method_table>> ptr(new std::shared_ptr<internal::native_method_table>(_table));
+        jobject obj = jni::new_object(_cls, _ctor, reinterpret_cast<jlong>(ptr.get()));
+        ptr.release();
+        return object(obj);
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <exception>
+#include <string>
+#include "..\java.h"
+
+namespace java
+{
+	class nosuchfield_exception : public std::exception
+	{
+		std::string _message;
+
+	public:
+		nosuchfield_exception(const clazz& c, const char* fieldName, const char* descriptor)
+			: _message("No such field '" + std::string(fieldName) + "' of type " + std::string(descriptor)
+				+ " found in class '" + c.name() + "'")
+		{
+		}
+
+		const char* what() const throw() override
+		{
+			return _message.c_str();
+		}
+	};
+}
@@ -30,11 +30,22 @@ namespace java
 		}
 
 	public:
-		nosuchmethod_exception(clazz c, const char* methodName, const std::vector<clazz>& classes)
+		nosuchmethod_exception(const clazz& c, const char* methodName, const std::vector<clazz>& classes)
 			: _message("No such method '" + std::string(methodName) 
 				+ "' found in class '" + c.name() + "'" 
 				+ join_arg_types(classes))
 		{
 		}
+
+		nosuchmethod_exception(const clazz& c, const char* methodName, const char* signature)
+			: _message("No such method '" + std::string(methodName) + std::string(signature)
+				+ "' found in class '" + c.name() + "'")
+		{
+		}
+
+		const char* what() const throw() override
+		{
+			return _message.c_str();
+		}
 	};
 }
\ No newline at end of file
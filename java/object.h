@@ -1,6 +1,9 @@
 #pragma once
 
 #include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 namespace java
 {
@@ -8,26 +11,119 @@ namespace java
     class method_list;
     class clazz;
     class array_element;
+    class object;
+    template <typename T> class result;
+
+    namespace internal
+    {
+        // Reads and writes fields through the Get/Set<Type>Field function 
+        // matching the JNI type.  Reference fields are read as java::object,
+        // so that the local reference is managed.
+        template <typename jtype, value_type = jni::descriptor<jtype>::value>
+        struct field_access;
+
+        // These fill in the jvalue passed for a call argument, and the class
+        // used to pick the method overload (null for null references).  Any
+        // local reference created along the way (the argument's class, or a
+        // java.lang.String for C strings) is handed to owned, so that it 
+        // lives until the call has been made.
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, const object& arg);
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, jobject arg);
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, const char* arg);
+
+        template <typename t>
+        typename std::enable_if<std::is_arithmetic<t>::value>::type set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, t arg);
+
+        // The arguments of a call, marshalled into arrays on the stack so 
+        // that the call can be made through the Call<Type>MethodA family 
+        // without any heap allocation.
+        template <size_t n>
+        struct arg_pack
+        {
+            static const size_t size = n;
+
+            jvalue values[n == 0 ? 1 : n];
+            jclass classes[n == 0 ? 1 : n];
+            local_ref<jobject> owned[n == 0 ? 1 : n];
+
+            template <typename... ts>
+            explicit arg_pack(const ts&... args)
+            {
+                size_t i = 0;
+                int expand[] = { 0, (set_arg(values[i], classes[i], owned[i], args), i++, 0)... };
+                (void)expand;
+            }
+        };
+    }
+
+    // Returns the interned java.lang.String for a string literal.  The empty
+    // string concatenation only compiles for literals, whose addresses key
+    // the cache.
+#define JAVA_STRING(literal) java::object::intern_literal("" literal)
+
+    namespace internal
+    {
+        // What the type predicates have found out so far about the class of
+        // the reference held by a java::object, so that asking again costs
+        // nothing.  Non-negative values mean the object is an array, and 
+        // give the JNI type of its elements (jobject_value for arrays of 
+        // references).
+        enum ref_shape
+        {
+            unknown_shape = -1,
+            string_shape = -2,
+            not_string_shape = -3,
+            plain_shape = -4
+        };
+    }
+
+    // Describes how a java::object holds its Java reference.  A borrowed 
+    // reference is owned by someone else (a local_frame, or the JVM in the 
+    // case of native method arguments) and is never deleted by the object.
+    enum ref_ownership
+    {
+        borrowed_ref,
+        owned_local_ref,
+        owned_global_ref
+    };
 
     // Generic container for any Java object.  This class is the fundamental 
     // type of the java::* namespace, and serves as a variant type that can 
     // contain any Java object- reference types, primitives and even a "void" 
     // type for Java methods that return void.
+    //
+    // An object owns its Java reference exclusively, and is move-only, so
+    // an extra JNI reference is never taken by accident.  clone() creates a
+    // new reference of the same kind (NewLocalRef or NewGlobalRef) that can
+    // be released independently, and make_global() only affects the object
+    // it is called on.  Objects holding local references must only be used
+    // on the thread that created them.
     class object
     {
     protected:
         value_type _type;
         jvalue _value;
-        local_ref<jobject> _ref;
+        ref_ownership _ownership;
+        mutable signed char _shape;
+
+        void release_ref();
 
     private:
+        // Converts a primitive or boxed number to the given numeric type, 
+        // returned in the matching member of the jvalue.
+        jvalue number_value(jni::value_type kind) const;
+
+        // Returns the JNI type of the array's elements, or plain_shape if 
+        // the object isn't an array.  The result is remembered, so only the
+        // first call goes to the JVM.
+        signed char array_shape() const;
+
         template <typename jtype>
         jtype get_element(size_t index)
         {
-            auto jobj = (typename jni::type_traits<jtype>::array_type)_ref.get();
-            auto ptr = jni::get_array_elements<jtype>(jobj, nullptr);
-            auto ret = ptr[index];
-            jni::release_array_elements<jtype>(jobj, ptr, JNI_ABORT);
+            auto jobj = (typename jni::type_traits<jtype>::array_type)_value.l;
+            jtype ret;
+            jni::get_array_region<jtype>(jobj, (jsize)index, 1, &ret);
             return ret;
         }
 
@@ -41,25 +137,65 @@ namespace java
         // This returns an object that serves as a "null reference" in Java
         static object null() { return object((jobject)nullptr); }
 
+        // Wraps a reference that is owned elsewhere, e.g., an argument of a
+        // native method.  The object never deletes the reference, and 
+        // clones of it are borrowed too.
+        static object borrow(jobject native);
+
+        // These return a java.lang.String from the per-VM string cache, so
+        // that text passed into Java repeatedly is only converted and 
+        // allocated once.  intern_literal() must be given a string literal
+        // (use the JAVA_STRING macro, which checks that at compile time), 
+        // and returns the cached global reference itself.  intern() accepts
+        // any text, keeps the most recently used strings, and returns a new
+        // local reference.
+        static object intern(const char* str);
+        static object intern(const std::string& str);
+        static object intern_literal(const char* literal);
+
         // These constructors create new Java objects of the various types.
-        object() : _type(void_value) { _value.l = nullptr; }
-        object(jobject native) : _type(jobject_value), _ref(native) { _value.l = native; }
-        object(jboolean native) : _type(jboolean_value) { _value.z = native; }
-        object(jbyte native) : _type(jbyte_value) { _value.b = native; }
-        object(jchar native) : _type(jchar_value) { _value.c = native; }
-        object(jdouble native) : _type(jdouble_value) { _value.d = native; }
-        object(jfloat native) : _type(jfloat_value) { _value.f = native; }
-        object(jint native) : _type(jint_value) { _value.i = native; }
-        object(jlong native) : _type(jlong_value) { _value.j = native; }
-        object(jshort native) : _type(jshort_value) { _value.s = native; }
+        // The jobject constructor takes ownership of a local reference 
+        // (unless a local_frame is active, in which case the frame owns it).
+        object() : _type(void_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.l = nullptr; }
+        object(jobject native);
+        object(jboolean native) : _type(jboolean_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.z = native; }
+        object(jbyte native) : _type(jbyte_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.b = native; }
+        object(jchar native) : _type(jchar_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.c = native; }
+        object(jdouble native) : _type(jdouble_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.d = native; }
+        object(jfloat native) : _type(jfloat_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.f = native; }
+        object(jint native) : _type(jint_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.i = native; }
+        object(jlong native) : _type(jlong_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.j = native; }
+        object(jshort native) : _type(jshort_value), _ownership(borrowed_ref), _shape(internal::unknown_shape) { _value.s = native; }
+
+        // These constructors take ownership of the reference held by a 
+        // reference handle.
+        template <typename jobject_t>
+        object(local_ref<jobject_t>&& ref) : object((jobject)ref.release()) {}
+
+        template <typename jobject_t>
+        object(global_ref<jobject_t>&& ref) : _type(jobject_value), _ownership(owned_global_ref), _shape(internal::unknown_shape) { _value.l = ref.release(); }
+
+        object(const object& other) = delete;
+        object(object&& other);
+        ~object();
+
+        object& operator= (const object& rhs) = delete;
+        object& operator= (object&& rhs);
+
+        // Returns another object holding a new reference of the same kind
+        // (local, global or borrowed) to the same Java object.  Objects are
+        // move-only, so this is the only way to copy one, and it costs a 
+        // call into the JVM.  Primitives are simply copied.
+        object clone() const;
 
         // Returns the clazz object associated with the current object.
         clazz get_clazz() const;
         
         // This constructor is a convenience for passing strings to Java 
         // methods.  It is the same as the jobject constructor, but allocates 
-        // a java.lang.String.
+        // a java.lang.String from UTF-8 text.
         object(const char* str);
+        object(const std::string& str);
 
         // This is a convenience for creating java.lang.Class Java objects 
         // from java::clazz C++ objects.
@@ -69,11 +205,34 @@ namespace java
         // if a field with the given name is not found.
         object field(const char* name);
 
+        // Reads or writes a non-static field of the given JNI type (jint, 
+        // jstring, jobject, ...).  The field ID is resolved once per class 
+        // and cached, after which this is a single Get/Set<Type>Field call.
+        // The type must match the field's declared type exactly, except 
+        // that jobject matches a public field of any reference type.  
+        // Reference fields are returned as java::object.  Throws 
+        // nosuchfield_exception if there is no such field.  For fields read
+        // in hot loops, resolve a field_handle with clazz::find_field.
+        template <typename jtype>
+        typename internal::field_access<jtype>::type get(const char* name) const;
+
+        template <typename jtype>
+        void set(const char* name, typename internal::field_access<jtype>::param_type value);
+
+        // Does the same as get(), but returns a failure to find the field
+        // instead of throwing it.
+        template <typename jtype>
+        result<typename internal::field_access<jtype>::type> try_get(const char* name) const;
+
         bool is_void() const;
 
         bool is_null() const;
         bool is_ref() const;
 
+        // The as_xxx() functions accept both the primitive value and its 
+        // boxed form (e.g., a java.lang.Integer for as_int()).  The boxed 
+        // form is unboxed through a cached method ID.  An exception is 
+        // thrown for any other type.
         bool is_bool() const;
         bool as_bool() const;
 		
@@ -98,9 +257,34 @@ namespace java
         bool is_double() const;
         jdouble as_double() const;
 		
+        // Returns the value of any primitive or boxed number (including 
+        // java.lang.Character, and any other java.lang.Number) converted to
+        // the given JNI type, e.g., as_number<jdouble>().
+        template <typename jtype>
+        jtype as_number() const
+        {
+            return jni::type_traits<jtype>::from_jvalue(number_value(jni::type_traits<jtype>::value));
+        }
+
+        // Checks whether the object is an instance of the given class, 
+        // using IsInstanceOf.  Primitives and null references are not 
+        // instances of anything.
+        bool instance_of(const clazz& cls) const;
+
         bool is_string() const;
+
+        // Returns the contents of a java.lang.String.  as_string() returns
+        // standard UTF-8 (NUL is a single byte, and supplementary 
+        // characters take four bytes), and as_u16string() returns the 
+        // UTF-16 characters exactly.  Use string_view or string_buffer to read the
+        // characters without converting them at all.
         std::string as_string() const;
+        std::u16string as_u16string() const;
 
+        // Checks whether the object is an array of any type.  The type 
+        // predicates remember what they find out, so after the first call
+        // (to this, is_string() or operator[]) they no longer call into the
+        // JVM for this object.
         bool is_array() const;
 
         // Don't confuse this with as_string().  This calls the 
@@ -108,11 +292,25 @@ namespace java
         // is itself a java.lang.String.
         std::string to_string() const;
 
-        local_ref<jobject> ref() { return _ref; }
+        // Returns how the object holds its reference.
+        ref_ownership ownership() const { return _ownership; }
+
+        // These return a new reference to the Java object held by this 
+        // object.  The object itself is left untouched.
+        local_ref<jobject> new_local() const;
+        global_ref<jobject> new_global() const;
+        weak_ref<jobject> new_weak() const;
         
         // Returns the JVM native jobject associated with this object.
         jobject native() const { return _value.l; }
 
+        // Returns the value as it is passed to the JNI (only the member 
+        // matching the type is meaningful).
+        const jvalue& jni_value() const { return _value; }
+
+        // Returns the JNI type of the value.
+        value_type type() const { return _type; }
+
         // Returns true if the object is a null reference.  Note that this 
         // will also return true for Java integers that happen to be zero.
         bool is_null() { return _value.l == nullptr; }
@@ -127,67 +325,133 @@ namespace java
         array_element operator[](size_t index);
 
 		// This returns a boxed object if the current value is a primitive type.  
-		// Otherwise returns a copy of the current object (i.e., a new reference to 
-		// the same java object).
+		// Otherwise returns a clone of the current object (i.e., a new reference to 
+		// the same java object).  Boxing goes through the wrapper's valueOf 
+		// method, so small values may come from the JVM's cache.
 		object box() const;
 
-        // These functions call Java methods on the object given the method 
-        // name and a number of arguments.  An exception is thrown if an 
+        // Calls a Java method on the object given the method name and any 
+        // number of arguments.  Arguments may be java::object's, raw 
+        // jobject's (which are borrowed), C strings or JNI primitives.  
+        // They are marshalled on the stack and the method is invoked 
+        // through Call<Type>MethodA.  An exception is thrown if an 
         // appropriate method is not found.
-        object call(const char* method_name);
-        object call(const char* method_name, object a1);
-        object call(const char* method_name, object a1, object a2);
-        object call(const char* method_name, object a1, object a2, object a3);
-        object call(const char* method_name, object a1, object a2, object a3, object a4);
-        object call(const char* method_name, object a1, object a2, object a3, object a4, object a5);
-        object call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6);
-        object call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6, object a7);
-        object call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6, object a7, object a8);
+        template <typename... ts>
+        object call(const char* method_name, const ts&... args)
+        {
+            internal::arg_pack<sizeof...(ts)> pack(args...);
+            return invoke(method_name, pack.values, pack.classes, pack.size);
+        }
+
+        // Does the same as call(), but returns failures (including any 
+        // exception thrown by the Java method) instead of throwing them.  
+        // The Java exception is cleared from the thread.
+        template <typename... ts>
+        result<object> try_call(const char* method_name, const ts&... args);
+
+    private:
+        object invoke(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
+        result<object> try_invoke(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
     };
 
-    // This class is used for updating elements in a Java primitive (int, 
-    // short, etc., non-object types) array.  When accessing primitive 
-    // arrays using JNI, the caller gets a pointer to memory that may or may 
-    // not have been copied.  Thus, the JNI provides a function to free this 
-    // memory (if applicable, a no-op otherwise).  The lifetime of objects 
-    // of this class control when this release function is called.  
-    // Furthermore, this class tracks whether the element is modified, in 
-    // order to tell the JNI whether to commit changes.
+    namespace internal
+    {
+        template <typename jtype, value_type>
+        struct field_access
+        {
+            typedef jtype type;
+            typedef jtype param_type;
+
+            static type get(jobject obj, jfieldID id) { return jni::get_field<jtype>(obj, id); }
+            static type get_static(jclass cls, jfieldID id) { return jni::get_static_field<jtype>(cls, id); }
+            static void set(jobject obj, jfieldID id, jtype v) { jni::set_field<jtype>(obj, id, v); }
+            static void set_static(jclass cls, jfieldID id, jtype v) { jni::set_static_field<jtype>(cls, id, v); }
+        };
+
+        template <typename jtype>
+        struct field_access<jtype, jobject_value>
+        {
+            typedef object type;
+            typedef const object& param_type;
+
+            static type get(jobject obj, jfieldID id) { return object(jni::get_field<jobject>(obj, id)); }
+            static type get_static(jclass cls, jfieldID id) { return object(jni::get_static_field<jobject>(cls, id)); }
+            static void set(jobject obj, jfieldID id, const object& v) { jni::set_field<jobject>(obj, id, v.native()); }
+            static void set_static(jclass cls, jfieldID id, const object& v) { jni::set_static_field<jobject>(cls, id, v.native()); }
+        };
+    }
+
+    namespace internal
+    {
+        template <typename t>
+        typename std::enable_if<std::is_arithmetic<t>::value>::type set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, t arg)
+        {
+            set_arg(value, cls, owned, object(arg));
+        }
+    }
+
+    template <typename jtype>
+    typename internal::field_access<jtype>::type object::get(const char* name) const
+    {
+        auto id = internal::get_member_cache().get_field(_value.l, internal::instance_field, name, jni::descriptor<jtype>::type::value);
+        return internal::field_access<jtype>::get(_value.l, id);
+    }
+
+    template <typename jtype>
+    void object::set(const char* name, typename internal::field_access<jtype>::param_type value)
+    {
+        auto id = internal::get_member_cache().get_field(_value.l, internal::instance_field, name, jni::descriptor<jtype>::type::value);
+        internal::field_access<jtype>::set(_value.l, id, value);
+    }
+
+    // This class is used for updating elements in a Java array.  It holds 
+    // the value of the element at the time it was read, and assigning to 
+    // it writes the new value back into the array.  Primitive elements are 
+    // read and written individually with Get/Set<Type>ArrayRegion, so for 
+    // bulk access use array_view, to_java() or from_java() instead.
     class array_element : public object
     {
-        local_ref<jarray> _array;
+        object _array;
         size_t _index;
 
     private:
         template <typename jtype>
         void set(jtype elem)
         {
-            auto jobj = (typename jni::type_traits<jtype>::array_type)_array.get();
-            auto ptr = jni::get_array_elements<jtype>(jobj, nullptr);
-            ptr[_index] = elem;
-            jni::release_array_elements<jtype>(jobj, ptr, JNI_COMMIT);
+            auto jobj = (typename jni::type_traits<jtype>::array_type)_array.native();
+            jni::set_array_region<jtype>(jobj, (jsize)_index, 1, &elem);
         }
 
         template <>
         void set<jobject>(jobject elem)
         {
-            jni::set_object_array_element((jobjectArray)_array.get(), _index, elem);
+            jni::set_object_array_element((jobjectArray)_array.native(), _index, elem);
         }
 
     public:
         template <typename jtype>
         array_element(object arr, jtype elem, size_t index)
-            : object(elem), _array(arr.ref()), _index(index) {}
+            : object(elem), _array(std::move(arr)), _index(index) {}
 
         // Modifies the element at the current index
         array_element& operator= (const object& rhs);
     };
 
-    // Creates a new object in the VM by calling it's parameterless c-tor.  
-    // Effectively does the same as "new class_name()" in Java.
-    object create(const char* class_name);
+    namespace internal
+    {
+        object construct(const char* class_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
+    }
 
-    object create(const char* class_name, object a1);
+    // Creates a new object in the VM by calling the constructor that 
+    // accepts the given arguments.  Effectively does the same as 
+    // "new class_name(args...)" in Java.  The arguments are marshalled the 
+    // same way as for object::call.
+    template <typename... ts>
+    object create(const char* class_name, const ts&... args)
+    {
+        internal::arg_pack<sizeof...(ts)> pack(args...);
+        return internal::construct(class_name, pack.values, pack.classes, pack.size);
+    }
 
     // Creates a new object (non-primitive) array.  This function is not 
     // suitable for creating primitive arrays, although it may be tempting 
@@ -202,4 +466,32 @@ namespace java
     {
         return object(jni::new_array<jtype>(size));
     }
+
+    // Creates a new Java primitive array holding a copy of the vector's 
+    // elements.  The elements are copied in a single Set<Type>ArrayRegion 
+    // call.  The element type must be a JNI type (jint, jdouble, etc.).
+    template <typename jtype>
+    object to_java(const std::vector<jtype>& values)
+    {
+        auto arr = jni::new_array<jtype>(values.size());
+        object ret(arr);
+        if (!values.empty())
+            jni::set_array_region<jtype>(arr, 0, (jsize)values.size(), values.data());
+        return ret;
+    }
+
+    // Copies the elements of a Java primitive array into a vector, using a 
+    // single Get<Type>ArrayRegion call.  The element type must match the 
+    // array's (e.g., jint for a Java int[]).
+    template <typename jtype>
+    std::vector<jtype> from_java(const object& arr)
+    {
+        if (!arr.is_ref() || arr.is_null()) throw std::exception("Not an array reference");
+
+        auto native = (typename jni::type_traits<jtype>::array_type)arr.native();
+        std::vector<jtype> ret(jni::get_array_length(native));
+        if (!ret.empty())
+            jni::get_array_region<jtype>(native, 0, (jsize)ret.size(), ret.data());
+        return ret;
+    }
 }
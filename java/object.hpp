@@ -2,44 +2,165 @@
 #include "object.h"
 #include "jvm.h"
 #include "clazz.h"
+#include <cstring>
 
 namespace java
 {
+    object object::borrow(jobject native)
+    {
+        object ret;
+        ret._type = jobject_value;
+        ret._value.l = native;
+        return ret;
+    }
+
+    object object::intern(const char* str)
+    {
+        object ret(internal::get_string_cache().get(str, strlen(str)));
+        ret._shape = internal::string_shape;
+        return ret;
+    }
+
+    object object::intern(const std::string& str)
+    {
+        object ret(internal::get_string_cache().get(str.data(), str.size()));
+        ret._shape = internal::string_shape;
+        return ret;
+    }
+
+    object object::intern_literal(const char* literal)
+    {
+        object ret = borrow(internal::get_string_cache().literal(literal));
+        ret._shape = internal::string_shape;
+        return ret;
+    }
+
+    object::object(jobject native)
+        : _type(jobject_value), _ownership(internal::in_local_frame() ? borrowed_ref : owned_local_ref), _shape(internal::unknown_shape)
+    {
+        _value.l = native;
+    }
+
     object::object(const char* str)
-        : _type(jobject_value)
+        : object((jobject)jni::new_string_utf8(str, strlen(str)))
+    {
+        _shape = internal::string_shape;
+    }
+
+    object::object(const std::string& str)
+        : object((jobject)jni::new_string_utf8(str.data(), str.size()))
     {
-        _ref = jni::new_string_utf(str);
-        _value.l = _ref.get();
+        _shape = internal::string_shape;
     }
 
     object::object(const clazz& cls)
-        : _type(jobject_value)
+        : object(cls.object::clone())
+    {
+    }
+
+    object object::clone() const
+    {
+        object ret;
+        ret._type = _type;
+        ret._value = _value;
+        ret._shape = _shape;
+        if (_type != jobject_value || _value.l == nullptr) return ret;
+
+        switch (_ownership)
+        {
+        case owned_local_ref:
+            ret._value.l = jni::new_local_ref(_value.l);
+            ret._ownership = internal::in_local_frame() ? borrowed_ref : owned_local_ref;
+            break;
+        case owned_global_ref:
+            ret._value.l = jni::new_global_ref(_value.l);
+            ret._ownership = owned_global_ref;
+            break;
+        default:
+            break;
+        }
+        return ret;
+    }
+
+    object::object(object&& other)
+        : _type(other._type), _value(other._value), _ownership(other._ownership), _shape(other._shape)
+    {
+        other._value.l = nullptr;
+        other._ownership = borrowed_ref;
+    }
+
+    object::~object()
     {
-        _ref = cls.ref();
-        _value.l = _ref.get();
+        release_ref();
+    }
+
+    object& object::operator= (object&& rhs)
+    {
+        if (this != &rhs)
+        {
+            release_ref();
+            _type = rhs._type;
+            _value = rhs._value;
+            _ownership = rhs._ownership;
+            _shape = rhs._shape;
+            rhs._value.l = nullptr;
+            rhs._ownership = borrowed_ref;
+        }
+        return *this;
+    }
+
+    void object::release_ref()
+    {
+        if (_type != jobject_value || _value.l == nullptr) return;
+
+        switch (_ownership)
+        {
+        case owned_local_ref: jni::delete_local_ref(_value.l); break;
+        case owned_global_ref: jni::delete_global_ref(_value.l); break;
+        default: break;
+        }
+
+        _ownership = borrowed_ref;
     }
 
     void object::make_global()
     {
-        if (_type == jobject_value)
+        if (_type == jobject_value && _value.l != nullptr && _ownership != owned_global_ref)
         {
-            _ref.make_global();
-            _value.l = _ref.get();
+            auto global = jni::new_global_ref(_value.l);
+            release_ref();
+            _value.l = global;
+            _ownership = owned_global_ref;
         }
     }
 
+    local_ref<jobject> object::new_local() const
+    {
+        return local_ref<jobject>(_type == jobject_value && _value.l != nullptr ? jni::new_local_ref(_value.l) : nullptr);
+    }
+
+    global_ref<jobject> object::new_global() const
+    {
+        return global_ref<jobject>(_type == jobject_value && _value.l != nullptr ? jni::new_global_ref(_value.l) : nullptr);
+    }
+
+    weak_ref<jobject> object::new_weak() const
+    {
+        return weak_ref<jobject>(_type == jobject_value && _value.l != nullptr ? jni::new_weak_global_ref(_value.l) : nullptr);
+    }
+
 	clazz object::get_clazz() const
     {
         switch (_type)
         {
-        case jboolean_value: return java::clazz("java/lang/Boolean").static_field("TYPE");
-        case jbyte_value: return java::clazz("java/lang/Byte").static_field("TYPE");
-        case jchar_value: return java::clazz("java/lang/Character").static_field("TYPE");
-        case jshort_value: return java::clazz("java/lang/Short").static_field("TYPE");
-        case jint_value: return java::clazz("java/lang/Integer").static_field("TYPE");
-        case jlong_value: return java::clazz("java/lang/Long").static_field("TYPE");
-        case jfloat_value: return java::clazz("java/lang/Float").static_field("TYPE");
-        case jdouble_value: return java::clazz("java/lang/Double").static_field("TYPE");
+        case jboolean_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jboolean_value)));
+        case jbyte_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jbyte_value)));
+        case jchar_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jchar_value)));
+        case jshort_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jshort_value)));
+        case jint_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jint_value)));
+        case jlong_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jlong_value)));
+        case jfloat_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jfloat_value)));
+        case jdouble_value: return clazz(object::borrow(internal::get_boxing_cache().primitive_class(jdouble_value)));
 		case jobject_value: return _value.l == nullptr ? clazz() : clazz(jni::get_object_class(native()));
 		    case void_value: throw std::exception("value is void");
 
@@ -63,9 +184,86 @@ namespace java
         return _type == jobject_value;
     }
 
+    namespace internal
+    {
+        // Unboxes a wrapper object (java.lang.Integer, etc.) through the 
+        // cached xxxValue method ID.
+        template <typename jtype>
+        static jtype unbox(jobject obj, const char* error)
+        {
+            auto& boxed = get_boxing_cache().get(jni::type_traits<jtype>::value);
+            if (obj == nullptr || !get_env()->IsInstanceOf(obj, boxed.cls)) throw std::exception(error);
+            return jni::call_methoda<jtype>(obj, boxed.unbox, nullptr);
+        }
+
+        template <typename t>
+        static jvalue number_to_jvalue(jni::value_type kind, t v)
+        {
+            jvalue ret;
+            switch (kind)
+            {
+            case jni::jbyte_value: ret.b = (jbyte)v; break;
+            case jni::jchar_value: ret.c = (jchar)v; break;
+            case jni::jshort_value: ret.s = (jshort)v; break;
+            case jni::jint_value: ret.i = (jint)v; break;
+            case jni::jlong_value: ret.j = (jlong)v; break;
+            case jni::jfloat_value: ret.f = (jfloat)v; break;
+            case jni::jdouble_value: ret.d = (jdouble)v; break;
+            default: throw std::exception("Not a numeric type");
+            }
+            return ret;
+        }
+    }
+
+    jvalue object::number_value(jni::value_type kind) const
+    {
+        switch (_type)
+        {
+        case jbyte_value: return internal::number_to_jvalue(kind, _value.b);
+        case jchar_value: return internal::number_to_jvalue(kind, _value.c);
+        case jshort_value: return internal::number_to_jvalue(kind, _value.s);
+        case jint_value: return internal::number_to_jvalue(kind, _value.i);
+        case jlong_value: return internal::number_to_jvalue(kind, _value.j);
+        case jfloat_value: return internal::number_to_jvalue(kind, _value.f);
+        case jdouble_value: return internal::number_to_jvalue(kind, _value.d);
+        case jobject_value: break;
+        default: throw std::exception("Java object is not a number");
+        }
+
+        if (_value.l == nullptr) throw std::exception("Java object is not a number");
+
+        auto env = internal::get_env();
+        auto& boxing = internal::get_boxing_cache();
+
+        if (env->IsInstanceOf(_value.l, boxing.number_class()))
+        {
+            // Number has no charValue, so chars are converted from ints
+            auto method_kind = kind == jni::jchar_value ? jni::jint_value : kind;
+            jvalue ret;
+            switch (method_kind)
+            {
+            case jni::jbyte_value: ret.b = jni::call_methoda<jbyte>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            case jni::jshort_value: ret.s = jni::call_methoda<jshort>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            case jni::jint_value: ret.i = jni::call_methoda<jint>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            case jni::jlong_value: ret.j = jni::call_methoda<jlong>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            case jni::jfloat_value: ret.f = jni::call_methoda<jfloat>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            case jni::jdouble_value: ret.d = jni::call_methoda<jdouble>(_value.l, boxing.number_method(method_kind), nullptr); break;
+            default: throw std::exception("Not a numeric type");
+            }
+            return kind == jni::jchar_value ? internal::number_to_jvalue(kind, ret.i) : ret;
+        }
+
+        auto& character = boxing.get(jni::jchar_value);
+        if (env->IsInstanceOf(_value.l, character.cls))
+            return internal::number_to_jvalue(kind, jni::call_methoda<jchar>(_value.l, character.unbox, nullptr));
+
+        throw std::exception("Java object is not a number");
+    }
+
     bool object::is_bool() const { return _type == jboolean_value; }
     bool object::as_bool() const
 	{
+		if (_type == jobject_value) return internal::unbox<jboolean>(_value.l, "Java object is not a boolean") == JNI_TRUE;
 		if (_type != jboolean_value) throw std::exception("Java object is not a boolean");
 		return _value.z == JNI_TRUE;
 	}
@@ -73,6 +271,7 @@ namespace java
     bool object::is_byte() const { return _type == jbyte_value; }
 	jbyte object::as_byte() const
 	{
+		if (_type == jobject_value) return internal::unbox<jbyte>(_value.l, "Java object is not a byte");
 		if (_type != jbyte_value) throw std::exception("Java object is not a byte");
 		return _value.b;
 	}
@@ -80,6 +279,7 @@ namespace java
     bool object::is_char() const { return _type == jchar_value; }
 	jchar object::as_char() const
 	{
+		if (_type == jobject_value) return internal::unbox<jchar>(_value.l, "Java object is not a char");
 		if (_type != jchar_value) throw std::exception("Java object is not a char");
 		return _value.c;
 	}
@@ -87,6 +287,7 @@ namespace java
     bool object::is_short() const { return _type == jshort_value; }
 	jshort object::as_short() const
 	{
+		if (_type == jobject_value) return internal::unbox<jshort>(_value.l, "Java object is not a short");
 		if (_type != jshort_value) throw std::exception("Java object is not a short");
 		return _value.s;
 	}
@@ -94,6 +295,7 @@ namespace java
     bool object::is_int() const { return _type == jint_value; }
 	jint object::as_int() const
 	{
+		if (_type == jobject_value) return internal::unbox<jint>(_value.l, "Java object is not a int");
 		if (_type != jint_value) throw std::exception("Java object is not a int");
 		return _value.i;
 	}
@@ -101,6 +303,7 @@ namespace java
     bool object::is_long() const { return _type == jlong_value; }
 	jlong object::as_long() const
 	{
+		if (_type == jobject_value) return internal::unbox<jlong>(_value.l, "Java object is not a long");
 		if (_type != jlong_value) throw std::exception("Java object is not a long");
 		return _value.j;
 	}
@@ -108,6 +311,7 @@ namespace java
     bool object::is_float() const { return _type == jfloat_value; }
 	jfloat object::as_float() const
 	{
+		if (_type == jobject_value) return internal::unbox<jfloat>(_value.l, "Java object is not a float");
 		if (_type != jfloat_value) throw std::exception("Java object is not a float");
 		return _value.f;
 	}
@@ -115,28 +319,79 @@ namespace java
     bool object::is_double() const { return _type == jdouble_value; }
 	jdouble object::as_double() const
 	{
+		if (_type == jobject_value) return internal::unbox<jdouble>(_value.l, "Java object is not a double");
 		if (_type != jdouble_value) throw std::exception("Java object is not a double");
 		return _value.d;
 	}
 
+    bool object::instance_of(const clazz& cls) const
+    {
+        if (_type != jobject_value || _value.l == nullptr) return false;
+        return internal::get_env()->IsInstanceOf(_value.l, cls.native()) == JNI_TRUE;
+    }
+
     bool object::is_string() const
     {
-        auto cls = get_clazz();
-        clazz stringCls("java/lang/String");
-        return cls.call("equals", stringCls).as_bool();
+        if (_type != jobject_value || _value.l == nullptr) return false;
+        if (_shape == internal::string_shape) return true;
+        if (_shape != internal::unknown_shape) return false;
+
+        // java.lang.String is final, so an instance check is the same as 
+        // comparing the classes.
+        auto string_class = internal::get_class_registry().find("java/lang/String");
+        bool ret = internal::get_env()->IsInstanceOf(_value.l, string_class) == JNI_TRUE;
+        _shape = ret ? internal::string_shape : internal::not_string_shape;
+        return ret;
     }
+
 	std::string object::as_string() const
 	{
 		if (!is_string()) throw std::exception("Java object is not a String");
 		return jstring_str(reinterpret_cast<jstring>(native()));
 	}
 
-    bool object::is_array() const
+	std::u16string object::as_u16string() const
+	{
+		if (!is_string()) throw std::exception("Java object is not a String");
+		return jstring_u16str(reinterpret_cast<jstring>(native()));
+	}
+
+    signed char object::array_shape() const
     {
-        if (is_null()) return false;
+        if (_shape >= 0) return _shape;
+        if (_shape == internal::string_shape || _shape == internal::plain_shape) return internal::plain_shape;
+
+        // Arrays of references are by far the most common, and a single 
+        // Object[] check covers all of them, including multi-dimensional 
+        // arrays.  Primitive array classes are final, so each of the others
+        // is one exact check.
+        static const jni::value_type kinds[] = {
+            jni::jobject_value, jni::jbyte_value, jni::jint_value, jni::jchar_value, jni::jlong_value,
+            jni::jdouble_value, jni::jfloat_value, jni::jshort_value, jni::jboolean_value
+        };
+        static const char* const names[] = {
+            "[Ljava/lang/Object;", "[B", "[I", "[C", "[J", "[D", "[F", "[S", "[Z"
+        };
+
+        auto env = internal::get_env();
+        auto& registry = internal::get_class_registry();
+        for (size_t i = 0; i < sizeof(kinds) / sizeof(kinds[0]); i++)
+        {
+            if (env->IsInstanceOf(_value.l, registry.find(names[i])) == JNI_TRUE)
+                return _shape = (signed char)kinds[i];
+        }
+
+        // Record whether it's a string too, so that neither predicate has
+        // to ask again.
+        if (_shape == internal::unknown_shape) is_string();
+        if (_shape != internal::string_shape) _shape = internal::plain_shape;
+        return internal::plain_shape;
+    }
 
-        auto name = get_clazz().name();
-        return name.size() > 1 && name[0] == '[';
+    bool object::is_array() const
+    {
+        if (_type != jobject_value || _value.l == nullptr) return false;
+        return array_shape() >= 0;
     }
 
     jsize object::array_size()
@@ -147,22 +402,21 @@ namespace java
 
     array_element object::operator[](size_t index)
     {
-        auto class_name = get_clazz().name();
-        if (class_name.size() < 2 || class_name[0] != '[') throw std::exception("Not an array type");
+        if (_type != jobject_value || _value.l == nullptr) throw std::exception("Not an array type");
 
-        switch (class_name[1])
+        switch (array_shape())
         {
-        case 'Z': return array_element(*this, get_element<jboolean>(index), index); break;
-        case 'B': return array_element(*this, get_element<jbyte>(index), index); break;
-        case 'C': return array_element(*this, get_element<jchar>(index), index); break;
-        case 'L': return array_element(*this, jni::get_object_array_element((jobjectArray)_ref.get(), index), index); break;
-        case 'D': return array_element(*this, get_element<jdouble>(index), index); break;
-        case 'F': return array_element(*this, get_element<jfloat>(index), index); break;
-        case 'I': return array_element(*this, get_element<jint>(index), index); break;
-        case 'J': return array_element(*this, get_element<jlong>(index), index); break;
-        case 'S': return array_element(*this, get_element<jshort>(index), index); break;
+        case jboolean_value: return array_element(clone(), get_element<jboolean>(index), index); break;
+        case jbyte_value: return array_element(clone(), get_element<jbyte>(index), index); break;
+        case jchar_value: return array_element(clone(), get_element<jchar>(index), index); break;
+        case jobject_value: return array_element(clone(), jni::get_object_array_element((jobjectArray)_value.l, index), index); break;
+        case jdouble_value: return array_element(clone(), get_element<jdouble>(index), index); break;
+        case jfloat_value: return array_element(clone(), get_element<jfloat>(index), index); break;
+        case jint_value: return array_element(clone(), get_element<jint>(index), index); break;
+        case jlong_value: return array_element(clone(), get_element<jlong>(index), index); break;
+        case jshort_value: return array_element(clone(), get_element<jshort>(index), index); break;
         default:
-            throw std::exception("Unsupported Java type");
+            throw std::exception("Not an array type");
         }
     }
 
@@ -175,164 +429,70 @@ namespace java
 
     object object::field(const char* name)
     {
-        return get_clazz().call_static("getField", name).call("get", *this);
+        return get_clazz().call_static("getField", intern(name)).call("get", *this);
     }
 
 	object object::box() const
 	{
-		switch (_type)
-		{
-		case jboolean_value: return create("java/lang/Boolean", _value.z);
-		case jbyte_value: return create("java/lang/Byte", _value.b);
-		case jchar_value: return create("java/lang/Character", _value.c);
-		case jshort_value: return create("java/lang/Short", _value.s);
-		case jint_value: return create("java/lang/Integer", _value.i);
-		case jlong_value: return create("java/lang/Long", _value.j);
-		case jfloat_value: return create("java/lang/Float", _value.f);
-		case jdouble_value: return create("java/lang/Double", _value.d);
-
-		default:
-			return *this;
-		}
+		if (_type == jobject_value || _type == void_value) return clone();
+
+		// The jvalue already holds the primitive in the member valueOf expects
+		auto& boxed = internal::get_boxing_cache().get(_type);
+		return object(jni::call_static_methoda<jobject>(boxed.cls, boxed.value_of, &_value));
 	}
 
-    object call_method(jobject obj, std::string& return_type, jmethodID id, ...)
+    namespace internal
     {
-        va_list args;
-        va_start(args, id);
-
-        object ret;
-
-        try
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, const object& arg)
         {
-            auto rtype = return_type;
-            if (return_type == "void")
+            if (arg.type() != jni::jobject_value)
             {
-                jni::call_methodv<void>(obj, id, args);
-                ret = object();
+                if (arg.is_void()) throw std::exception("Can't pass a void value as an argument");
+                value = arg.jni_value();
+                cls = get_boxing_cache().primitive_class(arg.type());
             }
-            else if (rtype == "boolean")
-                ret = object(jni::call_methodv<jboolean>(obj, id, args));
-            else if (rtype == "byte")
-                ret = object(jni::call_methodv<jbyte>(obj, id, args));
-            else if (rtype == "char")
-                ret = object(jni::call_methodv<jchar>(obj, id, args));
-            else if (rtype == "double")
-                ret = object(jni::call_methodv<jdouble>(obj, id, args));
-            else if (rtype == "float")
-                ret = object(jni::call_methodv<jfloat>(obj, id, args));
-            else if (rtype == "int")
-                ret = object(jni::call_methodv<jint>(obj, id, args));
-            else if (rtype == "long")
-                ret = object(jni::call_methodv<jlong>(obj, id, args));
-            else if (rtype == "short")
-                ret = object(jni::call_methodv<jshort>(obj, id, args));
             else
-                ret = object(jni::call_methodv<jobject>(obj, id, args));
+            {
+                set_arg(value, cls, owned, arg.native());
+            }
         }
-        catch (...)
+
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, jobject arg)
         {
-            va_end(args);
-            throw;
+            value.l = arg;
+            owned = arg == nullptr ? nullptr : jni::get_object_class(arg);
+            cls = (jclass)owned.get();
         }
 
-        va_end(args);
+        void set_arg(jvalue& value, jclass& cls, local_ref<jobject>& owned, const char* arg)
+        {
+            owned = jni::new_string_utf8(arg, strlen(arg));
+            value.l = owned.get();
+            cls = get_class_registry().find("java/lang/String");
+        }
 
-        return ret;
+        static object call_methoda(jobject obj, jni::value_type return_kind, jmethodID id, const jvalue* args)
+        {
+            switch (return_kind)
+            {
+            case jni::void_value: jni::call_methoda<void>(obj, id, args); return object();
+            case jni::jboolean_value: return object(jni::call_methoda<jboolean>(obj, id, args));
+            case jni::jbyte_value: return object(jni::call_methoda<jbyte>(obj, id, args));
+            case jni::jchar_value: return object(jni::call_methoda<jchar>(obj, id, args));
+            case jni::jdouble_value: return object(jni::call_methoda<jdouble>(obj, id, args));
+            case jni::jfloat_value: return object(jni::call_methoda<jfloat>(obj, id, args));
+            case jni::jint_value: return object(jni::call_methoda<jint>(obj, id, args));
+            case jni::jlong_value: return object(jni::call_methoda<jlong>(obj, id, args));
+            case jni::jshort_value: return object(jni::call_methoda<jshort>(obj, id, args));
+            default: return object(jni::call_methoda<jobject>(obj, id, args));
+            }
+        }
     }
 
-    // These functions call Java methods on the object given the method 
-    // name and a number of arguments.  An exception is thrown if an 
-    // appropriate method is not found.
-    object object::call(const char* method_name)
-    {
-        std::vector<clazz> classes;
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id());
-    }
-    object object::call(const char* method_name, object a1)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native());
-    }
-    object object::call(const char* method_name, object a1, object a2)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3, object a4)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native(), a4.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3, object a4, object a5)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        classes.push_back(a5.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native(), a4.native(), a5.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        classes.push_back(a5.get_clazz());
-        classes.push_back(a6.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native(), a4.native(), a5.native(), a6.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6, object a7)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        classes.push_back(a5.get_clazz());
-        classes.push_back(a6.get_clazz());
-        classes.push_back(a7.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native(), a4.native(), a5.native(), a6.native(), a7.native());
-    }
-    object object::call(const char* method_name, object a1, object a2, object a3, object a4, object a5, object a6, object a7, object a8)
-    {
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        classes.push_back(a4.get_clazz());
-        classes.push_back(a5.get_clazz());
-        classes.push_back(a6.get_clazz());
-        classes.push_back(a7.get_clazz());
-        classes.push_back(a8.get_clazz());
-        auto m = get_clazz().lookup_method(method_name, classes);
-        return call_method(_value.l, m.return_type(), m.id(), a1.native(), a2.native(), a3.native(), a4.native(), a5.native(), a6.native(), a7.native(), a8.native());
+    object object::invoke(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
+    {
+        auto& m = get_clazz().resolve_method(method_name, arg_classes, num_args);
+        return internal::call_methoda(_value.l, m.return_kind, m.id, args);
     }
 
     array_element& array_element::operator= (const object& rhs)
@@ -355,42 +515,14 @@ namespace java
         return *this;
     }
 
-    object create(const char* class_name)
-    {
-        clazz cls(class_name);
-        std::vector<clazz> classes;
-        auto ctor = cls.lookup_constructor(classes);
-        return jni::new_object(cls.native(), ctor.id());
-    }
-
-    object create(const char* class_name, object a1)
-    {
-        clazz cls(class_name);
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        auto ctor = cls.lookup_constructor(classes);
-        return jni::new_object(cls.native(), ctor.id(), a1.native());
-    }
-
-    object create(const char* class_name, object a1, object a2)
-    {
-        clazz cls(class_name);
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        auto ctor = cls.lookup_constructor(classes);
-        return jni::new_object(cls.native(), ctor.id(), a1.native(), a2.native());
-    }
-
-    object create(const char* class_name, object a1, object a2, object a3)
+    namespace internal
     {
-        clazz cls(class_name);
-        std::vector<clazz> classes;
-        classes.push_back(a1.get_clazz());
-        classes.push_back(a2.get_clazz());
-        classes.push_back(a3.get_clazz());
-        auto ctor = cls.lookup_constructor(classes);
-        return jni::new_object(cls.native(), ctor.id(), a1.native(), a2.native(), a3.native());
+        object construct(const char* class_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
+        {
+            clazz cls(class_name);
+            auto& ctor = cls.resolve_method("<init>", arg_classes, num_args);
+            return jni::new_objecta(cls.native(), ctor.id, args);
+        }
     }
 
     // Creates a new object (non-primitive) array
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "java\object.h"
+#include "java\clazz.h"
+#include <string>
+#include <utility>
+
+namespace java
+{
+    // The reason a try_* function failed.  This is either a Java throwable,
+    // which has been cleared from the thread, or an error found by the
+    // library itself (e.g., no method accepts the arguments).  Nothing
+    // about the throwable is fetched from the JVM unless it is asked for.
+    class java_error
+    {
+        object _throwable;
+        std::string _reason;
+
+    public:
+        java_error() {}
+        explicit java_error(object throwable) : _throwable(std::move(throwable)) {}
+        explicit java_error(std::string reason) : _reason(std::move(reason)) {}
+
+        // Takes the exception pending on the thread and clears it.
+        static java_error take_pending(JNIEnv* env);
+
+        // Returns true if the error is a Java exception, in which case
+        // throwable() returns it.
+        bool is_java_exception() const { return _throwable.is_ref(); }
+
+        const object& throwable() const { return _throwable; }
+
+        // Checks whether the error is a Java exception of the given class.
+        bool instance_of(const clazz& cls) const { return _throwable.instance_of(cls); }
+
+        // Returns Throwable.getMessage() for Java exceptions, or the
+        // library's description of the error.
+        std::string message() const;
+
+        // Throws the error as a C++ exception, of the type that would have
+        // been thrown by the throwing API.
+        [[noreturn]] void raise() const;
+    };
+
+    namespace internal
+    {
+        template <typename T>
+        T copy_of(const T& value) { return value; }
+
+        inline object copy_of(const object& value) { return value.clone(); }
+    }
+
+    // The outcome of a try_* function: a value, or the java_error that
+    // prevented it.  Failures are returned rather than thrown, so code that
+    // expects Java calls to fail routinely (Integer.parseInt on user input,
+    // say) doesn't pay for C++ exception unwinding.
+    template <typename T>
+    class result
+    {
+        T _value;
+        java_error _error;
+        bool _ok;
+
+    public:
+        result(T value) : _value(std::move(value)), _ok(true) {}
+        result(java_error error) : _value(), _error(std::move(error)), _ok(false) {}
+
+        bool ok() const { return _ok; }
+        explicit operator bool() const { return _ok; }
+
+        // Returns the value, or throws the error if there isn't one.
+        T& value()
+        {
+            if (!_ok) _error.raise();
+            return _value;
+        }
+
+        const T& value() const
+        {
+            if (!_ok) _error.raise();
+            return _value;
+        }
+
+        // Objects are move-only, so the value is cloned rather than copied.
+        T value_or(T fallback) const { return _ok ? internal::copy_of(_value) : std::move(fallback); }
+
+        const java_error& error() const { return _error; }
+    };
+
+    namespace internal
+    {
+        // Resolving methods and fields goes through the same caches as the
+        // throwing API.  Failing to resolve one is unusual (it means the
+        // caller has a bug), so those failures still go through a C++
+        // exception internally before being returned as a java_error.
+        // Exceptions thrown by the Java code being called never are.
+        result<object> try_construct(const char* class_name, const jvalue* args, const jclass* arg_classes, size_t num_args);
+
+        // Builds a java_error from a C++ exception thrown while resolving.
+        java_error error_from(const std::exception& e);
+    }
+
+    template <typename... ts>
+    result<object> object::try_call(const char* method_name, const ts&... args)
+    {
+        internal::arg_pack<sizeof...(ts)> pack(args...);
+        return try_invoke(method_name, pack.values, pack.classes, pack.size);
+    }
+
+    template <typename jtype>
+    result<typename internal::field_access<jtype>::type> object::try_get(const char* name) const
+    {
+        jfieldID id;
+        try
+        {
+            id = internal::get_member_cache().get_field(_value.l, internal::instance_field, name, jni::descriptor<jtype>::type::value);
+        }
+        catch (const std::exception& e)
+        {
+            return internal::error_from(e);
+        }
+        return internal::field_access<jtype>::get(_value.l, id);
+    }
+
+    template <typename... ts>
+    result<object> clazz::try_call_static(const char* method_name, const ts&... args)
+    {
+        internal::arg_pack<sizeof...(ts)> pack(args...);
+        return try_invoke_static(method_name, pack.values, pack.classes, pack.size);
+    }
+
+    // Does the same as create(), but returns failures (including exceptions
+    // thrown by the constructor) instead of throwing them.
+    template <typename... ts>
+    result<object> try_create(const char* class_name, const ts&... args)
+    {
+        internal::arg_pack<sizeof...(ts)> pack(args...);
+        return internal::try_construct(class_name, pack.values, pack.classes, pack.size);
+    }
+}
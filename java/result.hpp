@@ -0,0 +1,155 @@
+
+#include "result.h"
+#include "exception.h"
+#include "jvm.h"
+
+namespace java
+{
+    namespace internal
+    {
+        namespace
+        {
+            // These call a method through the non-throwing JNI functions,
+            // for try_calla below.
+            struct instance_call
+            {
+                jobject obj;
+                jmethodID id;
+                const jvalue* args;
+
+                template <typename jtype>
+                jtype invoke(JNIEnv* env) const { return jni::type_traits<jtype>::call_methoda(env, obj, id, args); }
+            };
+
+            struct static_call
+            {
+                jclass cls;
+                jmethodID id;
+                const jvalue* args;
+
+                template <typename jtype>
+                jtype invoke(JNIEnv* env) const { return jni::type_traits<jtype>::call_static_methoda(env, cls, id, args); }
+            };
+
+            template <typename call_t>
+            result<object> try_calla(const call_t& call, jni::value_type return_kind)
+            {
+                auto env = get_env();
+                object ret;
+
+                switch (return_kind)
+                {
+                case jni::void_value: call.template invoke<void>(env); break;
+                case jni::jboolean_value: ret = object(call.template invoke<jboolean>(env)); break;
+                case jni::jbyte_value: ret = object(call.template invoke<jbyte>(env)); break;
+                case jni::jchar_value: ret = object(call.template invoke<jchar>(env)); break;
+                case jni::jdouble_value: ret = object(call.template invoke<jdouble>(env)); break;
+                case jni::jfloat_value: ret = object(call.template invoke<jfloat>(env)); break;
+                case jni::jint_value: ret = object(call.template invoke<jint>(env)); break;
+                case jni::jlong_value: ret = object(call.template invoke<jlong>(env)); break;
+                case jni::jshort_value: ret = object(call.template invoke<jshort>(env)); break;
+                default: ret = object(call.template invoke<jobject>(env)); break;
+                }
+
+                if (env->ExceptionCheck()) return java_error::take_pending(env);
+                return ret;
+            }
+        }
+
+        java_error error_from(const std::exception& e)
+        {
+            // A java::exception is left pending in the JVM when it's thrown,
+            // but the try_* functions promise to leave the thread clean.
+            auto ex = dynamic_cast<const exception*>(&e);
+            if (ex == nullptr) return java_error(std::string(e.what()));
+
+            get_env()->ExceptionClear();
+            return java_error(ex->object::clone());
+        }
+
+        result<object> try_construct(const char* class_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
+        {
+            jclass cls;
+            jmethodID id;
+            try
+            {
+                clazz c(class_name);
+                id = c.resolve_method("<init>", arg_classes, num_args).id;
+                cls = c.native();
+            }
+            catch (const std::exception& e)
+            {
+                return error_from(e);
+            }
+
+            auto env = get_env();
+            jobject obj = env->NewObjectA(cls, id, args);
+            if (env->ExceptionCheck()) return java_error::take_pending(env);
+            return object(obj);
+        }
+    }
+
+    java_error java_error::take_pending(JNIEnv* env)
+    {
+        jthrowable t = env->ExceptionOccurred();
+        env->ExceptionClear();
+        return java_error(object(t));
+    }
+
+    std::string java_error::message() const
+    {
+        if (!is_java_exception()) return _reason;
+
+        auto env = internal::get_env();
+        auto id = internal::get_exception_registry().method(internal::throwable_get_message);
+        local_ref<jstring> msg = (jstring)env->CallObjectMethod(_throwable.native(), id);
+        if (env->ExceptionCheck())
+        {
+            env->ExceptionClear();
+            return "(unavailable)";
+        }
+        return msg ? jstring_str(msg.get()) : "(null)";
+    }
+
+    void java_error::raise() const
+    {
+        if (!is_java_exception()) throw std::exception(_reason.c_str());
+
+        auto t = (jthrowable)_throwable.native();
+        auto thrower = internal::get_exception_registry().find(t);
+        if (thrower != nullptr) thrower(t);
+        throw exception(t);
+    }
+
+    result<object> object::try_invoke(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
+    {
+        const internal::resolved_method* m;
+        try
+        {
+            m = &get_clazz().resolve_method(method_name, arg_classes, num_args);
+        }
+        catch (const std::exception& e)
+        {
+            return internal::error_from(e);
+        }
+
+        internal::instance_call call = { _value.l, m->id, args };
+        return internal::try_calla(call, m->return_kind);
+    }
+
+    result<object> clazz::try_invoke_static(const char* method_name, const jvalue* args, const jclass* arg_classes, size_t num_args)
+    {
+        const internal::resolved_method* m;
+        try
+        {
+            m = &resolve_method(method_name, arg_classes, num_args);
+        }
+        catch (const std::exception& e)
+        {
+            return internal::error_from(e);
+        }
+
+        internal::static_call call = { native(), m->id, args };
+        return internal::try_calla(call, m->return_kind);
+    }
+}
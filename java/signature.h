@@ -0,0 +1,80 @@
+#pragma once
+
+#include "jni.h"
+#include "java\type_traits.h"
+
+namespace java
+{
+    namespace jni
+    {
+        // Concatenates any number of chars<...> types into a single one.
+        template <typename... seqs>
+        struct concat;
+
+        template <>
+        struct concat<>
+        {
+            typedef chars<> type;
+        };
+
+        template <char... cs>
+        struct concat<chars<cs...>>
+        {
+            typedef chars<cs...> type;
+        };
+
+        template <char... lhs, char... rhs, typename... rest>
+        struct concat<chars<lhs...>, chars<rhs...>, rest...>
+        {
+            typedef typename concat<chars<lhs..., rhs...>, rest...>::type type;
+        };
+
+        // The JNI type descriptor for a C++ type, as a chars<...> type.  
+        // Primitives, void and jobject use the descriptor declared by their
+        // type_traits.  The other JNI reference types are mapped to the Java
+        // class they stand for.  Specialize this template to give other 
+        // C++ types (e.g., tag types for application classes) a descriptor,
+        // along with the "value" member used to pick the JNI call.
+        template <typename jtype>
+        struct descriptor
+        {
+            typedef typename type_traits<jtype>::descriptor type;
+            typedef jtype jni_type;
+            static const value_type value = type_traits<jtype>::value;
+        };
+
+#define decl_reference_descriptor(jtype, ...) \
+        template <> \
+        struct descriptor<jtype> \
+        { \
+            typedef chars<__VA_ARGS__> type; \
+            typedef jtype jni_type; \
+            static const value_type value = jobject_value; \
+        }
+
+        decl_reference_descriptor(jstring, 'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'S', 't', 'r', 'i', 'n', 'g', ';');
+        decl_reference_descriptor(jclass, 'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'C', 'l', 'a', 's', 's', ';');
+        decl_reference_descriptor(jthrowable, 'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'T', 'h', 'r', 'o', 'w', 'a', 'b', 'l', 'e', ';');
+        decl_reference_descriptor(jobjectArray, '[', 'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'O', 'b', 'j', 'e', 'c', 't', ';');
+        decl_reference_descriptor(jbooleanArray, '[', 'Z');
+        decl_reference_descriptor(jbyteArray, '[', 'B');
+        decl_reference_descriptor(jcharArray, '[', 'C');
+        decl_reference_descriptor(jshortArray, '[', 'S');
+        decl_reference_descriptor(jintArray, '[', 'I');
+        decl_reference_descriptor(jlongArray, '[', 'J');
+        decl_reference_descriptor(jfloatArray, '[', 'F');
+        decl_reference_descriptor(jdoubleArray, '[', 'D');
+
+        // The JNI method descriptor for a function type, e.g., 
+        // signature<jlong(jint, jstring)>::value is "(ILjava/lang/String;)J".
+        // The string is assembled by the compiler and has static storage.
+        template <typename sig>
+        struct signature;
+
+        template <typename ret, typename... args>
+        struct signature<ret(args...)>
+            : concat<chars<'('>, typename descriptor<args>::type..., chars<')'>, typename descriptor<ret>::type>::type
+        {
+        };
+    }
+}
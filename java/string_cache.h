@@ -0,0 +1,88 @@
+#pragma once
+
+#include "jni.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace java
+{
+    namespace internal
+    {
+        // This class holds global references to java.lang.String objects
+        // for text that is passed into Java over and over again (map keys,
+        // enum names, field names, ...), so that each one is transcoded and
+        // allocated once rather than on every call.
+        //
+        // String literals are keyed by their address, which is fixed for
+        // the life of the program, so a lookup is a pointer hash and a short
+        // chain walk without comparing any characters.  Like the other
+        // per-VM caches, literal entries are published with an atomic push
+        // and readers never take a lock.  Literals are never evicted, since
+        // a program only has so many of them.
+        //
+        // Any other text is keyed by its contents.  Those entries are kept
+        // in least recently used order behind a mutex, and the oldest ones
+        // are dropped once there are more than capacity() of them.  Since
+        // an evicted string's global reference is deleted, lookups of
+        // dynamic keys hand out a new local reference rather than the
+        // cached global one.
+        class string_cache
+        {
+            static const size_t bucket_count = 256;
+
+            struct literal_entry
+            {
+                const char* key;
+                jstring str;
+                literal_entry* next;
+            };
+
+            struct dynamic_entry
+            {
+                std::string key;
+                jstring str;
+            };
+
+            typedef std::list<dynamic_entry> lru_list;
+
+            std::atomic<literal_entry*> _literals[bucket_count];
+
+            // Most recently used first
+            std::mutex _mutex;
+            lru_list _lru;
+            std::unordered_map<std::string, lru_list::iterator> _index;
+            size_t _capacity;
+
+            void evict();
+
+            string_cache(const string_cache&);
+            string_cache& operator= (const string_cache&);
+
+        public:
+            static const size_t default_capacity = 1024;
+
+            string_cache();
+            ~string_cache();
+
+            // Returns the string for a literal, creating it on first use.
+            // The key must have static storage duration.  The reference is
+            // a global reference owned by the cache.
+            jstring literal(const char* key);
+
+            // Returns a new local reference to the string with the given
+            // UTF-8 contents, creating and caching it if needed.
+            jstring get(const char* data, size_t len);
+
+            // The maximum number of dynamic keys kept.  Lowering it evicts
+            // the least recently used strings straight away.
+            size_t capacity();
+            void capacity(size_t n);
+
+            // Deletes all strings and the global references held to them.
+            void clear();
+        };
+    }
+}
@@ -0,0 +1,142 @@
+
+#include "string_cache.h"
+#include "jvm.h"
+#include <cstring>
+
+namespace java
+{
+    namespace internal
+    {
+        string_cache::string_cache()
+            : _capacity(default_capacity)
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+                _literals[i].store(nullptr, std::memory_order_relaxed);
+        }
+
+        string_cache::~string_cache()
+        {
+            // The JVM may already be gone at this point, so only the memory
+            // is released here.  Call clear() beforehand to release the
+            // global references.
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                literal_entry* e = _literals[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    literal_entry* next = e->next;
+                    delete e;
+                    e = next;
+                }
+            }
+        }
+
+        jstring string_cache::literal(const char* key)
+        {
+            auto& bucket = _literals[((size_t)key >> 3) % bucket_count];
+
+            for (literal_entry* e = bucket.load(std::memory_order_acquire); e != nullptr; e = e->next)
+            {
+                if (e->key == key) return e->str;
+            }
+
+            // Two threads may both create the string, which is harmless since
+            // lookups return the first match.
+            local_ref<jstring> local = jni::new_string_utf8(key, strlen(key));
+
+            literal_entry* e = new literal_entry();
+            e->key = key;
+            e->str = (jstring)jni::new_global_ref(local.get());
+
+            e->next = bucket.load(std::memory_order_relaxed);
+            while (!bucket.compare_exchange_weak(e->next, e, std::memory_order_release, std::memory_order_relaxed))
+                ;
+
+            return e->str;
+        }
+
+        jstring string_cache::get(const char* data, size_t len)
+        {
+            std::string key(data, len);
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                auto it = _index.find(key);
+                if (it != _index.end())
+                {
+                    _lru.splice(_lru.begin(), _lru, it->second);
+                    return (jstring)jni::new_local_ref(it->second->str);
+                }
+            }
+
+            // The string is created outside the lock, since it calls into
+            // the JVM.  If another thread got there first, its string is
+            // used and this one is dropped.
+            local_ref<jstring> local = jni::new_string_utf8(data, len);
+            auto global = (jstring)jni::new_global_ref(local.get());
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            auto it = _index.find(key);
+            if (it != _index.end())
+            {
+                jni::delete_global_ref(global);
+                _lru.splice(_lru.begin(), _lru, it->second);
+                return (jstring)jni::new_local_ref(it->second->str);
+            }
+
+            dynamic_entry e;
+            e.key = key;
+            e.str = global;
+            _lru.push_front(e);
+            _index[key] = _lru.begin();
+            evict();
+
+            return local.release();
+        }
+
+        void string_cache::evict()
+        {
+            while (_lru.size() > _capacity)
+            {
+                auto& oldest = _lru.back();
+                jni::delete_global_ref(oldest.str);
+                _index.erase(oldest.key);
+                _lru.pop_back();
+            }
+        }
+
+        size_t string_cache::capacity()
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _capacity;
+        }
+
+        void string_cache::capacity(size_t n)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _capacity = n;
+            evict();
+        }
+
+        void string_cache::clear()
+        {
+            for (size_t i = 0; i < bucket_count; i++)
+            {
+                literal_entry* e = _literals[i].exchange(nullptr);
+                while (e != nullptr)
+                {
+                    literal_entry* next = e->next;
+                    jni::delete_global_ref(e->str);
+                    delete e;
+                    e = next;
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(_mutex);
+            for (auto it = _lru.begin(); it != _lru.end(); it++)
+                jni::delete_global_ref(it->str);
+            _lru.clear();
+            _index.clear();
+        }
+    }
+}
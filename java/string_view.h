@@ -0,0 +1,122 @@
+#pragma once
+
+#include "java\object.h"
+#include <string>
+#include <vector>
+
+namespace java
+{
+    // This class gives C++ code direct, read-only access to the UTF-16
+    // characters of a java.lang.String, through GetStringCritical.  The JVM
+    // usually hands out a pointer to the string's own storage, so nothing
+    // is copied or transcoded.  Like critical_array_view, the JVM may
+    // suspend garbage collection while the view exists, so no other JNI
+    // functions may be called (including any other java::* functions) and
+    // the thread must not block until the view is destroyed.  The
+    // java::object holding the string must outlive the view.
+    class string_view
+    {
+        jstring _str;
+        const jchar* _data;
+        jsize _size;
+        jboolean _is_copy;
+
+        string_view(const string_view&);
+        string_view& operator= (const string_view&);
+
+    public:
+        typedef jchar value_type;
+        typedef const jchar* const_iterator;
+        typedef jsize size_type;
+
+        string_view(const object& str);
+        string_view(string_view&& other);
+        ~string_view();
+
+        const jchar* data() const { return _data; }
+
+        // The number of UTF-16 code units in the string.
+        jsize size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        bool is_copy() const { return _is_copy == JNI_TRUE; }
+
+        jchar operator[] (jsize i) const { return _data[i]; }
+
+        const_iterator begin() const { return _data; }
+        const_iterator end() const { return _data + _size; }
+
+        std::u16string to_u16string() const
+        {
+            return std::u16string(reinterpret_cast<const char16_t*>(_data), _size);
+        }
+    };
+
+    // This class copies the UTF-16 characters of a java.lang.String (or a
+    // range of them) with GetStringRegion.  Strings of up to small_size
+    // characters are copied into a buffer inside the object, so reading a
+    // short string onto the stack doesn't allocate at all, on either side
+    // of the JNI.  Unlike string_view, there are no restrictions on what
+    // the thread can do while the buffer exists.
+    template <jsize small_size = 128>
+    class string_buffer
+    {
+        jchar _small[small_size];
+        std::vector<jchar> _large;
+        jchar* _data;
+        jsize _size;
+
+        string_buffer(const string_buffer&);
+        string_buffer& operator= (const string_buffer&);
+
+        void read(jstring str, jsize start, jsize len)
+        {
+            _size = len;
+            if (len <= small_size)
+            {
+                _data = _small;
+            }
+            else
+            {
+                _large.resize(len);
+                _data = _large.data();
+            }
+            if (len > 0) jni::get_string_region(str, start, len, _data);
+        }
+
+    public:
+        typedef jchar value_type;
+        typedef const jchar* const_iterator;
+        typedef jsize size_type;
+
+        // Copies the whole string.
+        string_buffer(const object& str)
+        {
+            if (!str.is_ref() || str.is_null()) throw std::exception("Not a string reference");
+            auto jstr = static_cast<jstring>(str.native());
+            read(jstr, 0, jni::get_string_length(jstr));
+        }
+
+        // Copies len characters, starting at start.
+        string_buffer(const object& str, jsize start, jsize len)
+        {
+            if (!str.is_ref() || str.is_null()) throw std::exception("Not a string reference");
+            read(static_cast<jstring>(str.native()), start, len);
+        }
+
+        const jchar* data() const { return _data; }
+
+        jsize size() const { return _size; }
+        bool empty() const { return _size == 0; }
+
+        jchar operator[] (jsize i) const { return _data[i]; }
+
+        const_iterator begin() const { return _data; }
+        const_iterator end() const { return _data + _size; }
+
+        std::u16string to_u16string() const
+        {
+            return std::u16string(reinterpret_cast<const char16_t*>(_data), _size);
+        }
+    };
+}
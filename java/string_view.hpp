@@ -0,0 +1,28 @@
+
+#include "string_view.h"
+#include "jvm.h"
+
+namespace java
+{
+    string_view::string_view(const object& str)
+        : _str(nullptr), _data(nullptr), _size(0), _is_copy(JNI_FALSE)
+    {
+        if (!str.is_ref() || str.is_null()) throw std::exception("Not a string reference");
+
+        // The length has to be read before entering the critical region.
+        _str = static_cast<jstring>(str.native());
+        _size = jni::get_string_length(_str);
+        _data = jni::get_string_critical(_str, &_is_copy);
+    }
+
+    string_view::string_view(string_view&& other)
+        : _str(other._str), _data(other._data), _size(other._size), _is_copy(other._is_copy)
+    {
+        other._data = nullptr;
+    }
+
+    string_view::~string_view()
+    {
+        if (_data != nullptr) jni::release_string_critical(_str, _data);
+    }
+}
@@ -4,21 +4,22 @@
 
 namespace java
 {
+	// Gives quick access to classes that are used all the time.  The 
+	// classes are resolved once per JVM through the class registry, and the
+	// clazz objects returned here borrow the registry's global references, 
+	// so they are cheap to create.
 	class thread_context
 	{
 	private:
-		JNIEnv* _env;
-		
-		clazz jstring_class;
-		clazz jint_class;
-		clazz class_class;
+		internal::class_registry& _classes;
 
 	public:
-		thread_context(JNIEnv* env)
-			: _env(env) {}
+		// Uses the registry of the JVM the current thread is attached to
+		thread_context();
 
-		clazz& get_jstring_class();
-		clazz& get_jint_class();
-		clazz& get_class_class();
+		clazz get_jstring_class();
+		clazz get_jint_class();
+		clazz get_class_class();
+		clazz get_object_class();
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,15 @@
+#include "thread_context.h"
+#include "jvm.h"
+
+namespace java
+{
+	thread_context::thread_context()
+		: _classes(internal::get_class_registry())
+	{
+	}
+
+	clazz thread_context::get_jstring_class() { return clazz(object::borrow(_classes.find("java/lang/String"))); }
+	clazz thread_context::get_jint_class() { return clazz(object::borrow(_classes.find("java/lang/Integer"))); }
+	clazz thread_context::get_class_class() { return clazz(object::borrow(_classes.find("java/lang/Class"))); }
+	clazz thread_context::get_object_class() { return clazz(object::borrow(_classes.find("java/lang/Object"))); }
+}
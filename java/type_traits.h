@@ -23,6 +23,18 @@ namespace java
             void_value
         };
 
+        // A string of characters encoded in a type, so that JNI type 
+        // descriptors can be assembled by the compiler.  The value array is
+        // null-terminated.
+        template <char... cs>
+        struct chars
+        {
+            static const char value[sizeof...(cs) + 1];
+        };
+
+        template <char... cs>
+        const char chars<cs...>::value[sizeof...(cs) + 1] = { cs..., '\0' };
+
         template <typename jtype>
         struct type_traits;
 
@@ -30,10 +42,13 @@ namespace java
         struct type_traits<void>
         {
             typedef void jni_type;
+            typedef chars<'V'> descriptor;
             static const value_type value = void_value;
 
             static jni_type call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args);
             static jni_type call_static_methodv(JNIEnv* env, jclass cls, jmethodID id, va_list args);
+            static jni_type call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args);
+            static jni_type call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args);
         };
 
         template <>
@@ -41,36 +56,53 @@ namespace java
         {
             typedef jobject jni_type;
             typedef jobjectArray array_type;
+            typedef chars<'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'O', 'b', 'j', 'e', 'c', 't', ';'> descriptor;
             static const value_type value = jobject_value;
 
+            static jvalue to_jvalue(jni_type v) { jvalue ret; ret.l = v; return ret; }
             static jni_type call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args);
             static jni_type call_static_methodv(JNIEnv* env, jclass cls, jmethodID id, va_list args);
+            static jni_type call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args);
+            static jni_type call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args);
+            static jni_type get_field(JNIEnv* env, jobject obj, jfieldID id);
+            static jni_type get_static_field(JNIEnv* env, jclass obj, jfieldID id);
+            static void set_field(JNIEnv* env, jobject obj, jfieldID id, jni_type v);
+            static void set_static_field(JNIEnv* env, jclass obj, jfieldID id, jni_type v);
         };
 
-#define decl_primitive_type_traits(jtype) \
+#define decl_primitive_type_traits(jtype, member, desc) \
         template <> \
         struct type_traits<jtype> \
         { \
             typedef jtype jni_type; \
             typedef jtype##Array array_type; \
+            typedef chars<desc> descriptor; \
             static const value_type value = jtype##_value; \
+            static jvalue to_jvalue(jni_type v) { jvalue ret; ret.member = v; return ret; } \
+            static jni_type from_jvalue(const jvalue& v) { return v.member; } \
             static jni_type call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args); \
             static jni_type call_static_methodv(JNIEnv* env, jclass cls, jmethodID id, va_list args); \
+            static jni_type call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args); \
+            static jni_type call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args); \
             static jni_type* get_array_elements(JNIEnv* env, array_type arr, jboolean* copy); \
             static void release_array_elements(JNIEnv* env, array_type arr, jni_type* ptr, jint mode); \
+            static void get_array_region(JNIEnv* env, array_type arr, jsize start, jsize len, jni_type* buf); \
+            static void set_array_region(JNIEnv* env, array_type arr, jsize start, jsize len, const jni_type* buf); \
             static jtype get_field(JNIEnv* env, jobject obj, jfieldID id); \
             static jtype get_static_field(JNIEnv* env, jclass obj, jfieldID id); \
+            static void set_field(JNIEnv* env, jobject obj, jfieldID id, jtype v); \
+            static void set_static_field(JNIEnv* env, jclass obj, jfieldID id, jtype v); \
             static array_type new_array(JNIEnv* env, size_t length); \
         }
 
-        decl_primitive_type_traits(jboolean);
-        decl_primitive_type_traits(jbyte);
-        decl_primitive_type_traits(jchar);
-        decl_primitive_type_traits(jshort);
-        decl_primitive_type_traits(jint);
-        decl_primitive_type_traits(jlong);
-        decl_primitive_type_traits(jfloat);
-        decl_primitive_type_traits(jdouble);
+        decl_primitive_type_traits(jboolean, z, 'Z');
+        decl_primitive_type_traits(jbyte, b, 'B');
+        decl_primitive_type_traits(jchar, c, 'C');
+        decl_primitive_type_traits(jshort, s, 'S');
+        decl_primitive_type_traits(jint, i, 'I');
+        decl_primitive_type_traits(jlong, j, 'J');
+        decl_primitive_type_traits(jfloat, f, 'F');
+        decl_primitive_type_traits(jdouble, d, 'D');
 
     }
 
@@ -7,6 +7,8 @@ namespace java
 	{
 		type_traits<void>::jni_type type_traits<void>::call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args) { return env->CallVoidMethodV(obj, id, args); }
 		type_traits<void>::jni_type type_traits<void>::call_static_methodv(JNIEnv* env, jclass cls, jmethodID id, va_list args) { return env->CallStaticVoidMethodV(cls, id, args); }
+		type_traits<void>::jni_type type_traits<void>::call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args) { return env->CallVoidMethodA(obj, id, args); }
+		type_traits<void>::jni_type type_traits<void>::call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args) { return env->CallStaticVoidMethodA(cls, id, args); }
 
 		type_traits<jobject>::jni_type type_traits<jobject>::call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args)
 		{
@@ -24,14 +26,55 @@ namespace java
 #endif
 			return ret;
 		}
+		type_traits<jobject>::jni_type type_traits<jobject>::call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args)
+		{
+			auto ret = env->CallObjectMethodA(obj, id, args);
+#ifdef DEBUG_REFS
+			_refs.push_back(ret);
+#endif
+			return ret;
+		}
+		type_traits<jobject>::jni_type type_traits<jobject>::call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args)
+		{
+			auto ret = env->CallStaticObjectMethodA(cls, id, args);
+#ifdef DEBUG_REFS
+			_refs.push_back(ret);
+#endif
+			return ret;
+		}
+
+		type_traits<jobject>::jni_type type_traits<jobject>::get_field(JNIEnv* env, jobject obj, jfieldID id)
+		{
+			auto ret = env->GetObjectField(obj, id);
+#ifdef DEBUG_REFS
+			_refs.push_back(ret);
+#endif
+			return ret;
+		}
+		type_traits<jobject>::jni_type type_traits<jobject>::get_static_field(JNIEnv* env, jclass obj, jfieldID id)
+		{
+			auto ret = env->GetStaticObjectField(obj, id);
+#ifdef DEBUG_REFS
+			_refs.push_back(ret);
+#endif
+			return ret;
+		}
+		void type_traits<jobject>::set_field(JNIEnv* env, jobject obj, jfieldID id, jni_type v) { env->SetObjectField(obj, id, v); }
+		void type_traits<jobject>::set_static_field(JNIEnv* env, jclass obj, jfieldID id, jni_type v) { env->SetStaticObjectField(obj, id, v); }
 
 #define def_primitive_type_traits(jtype, cap_name) \
 	type_traits<jtype>::jni_type type_traits<jtype>::call_methodv(JNIEnv* env, jobject obj, jmethodID id, va_list args) { return env->Call##cap_name##MethodV(obj, id, args); } \
 	type_traits<jtype>::jni_type type_traits<jtype>::call_static_methodv(JNIEnv* env, jclass cls, jmethodID id, va_list args) { return env->CallStatic##cap_name##MethodV(cls, id, args); } \
+	type_traits<jtype>::jni_type type_traits<jtype>::call_methoda(JNIEnv* env, jobject obj, jmethodID id, const jvalue* args) { return env->Call##cap_name##MethodA(obj, id, args); } \
+	type_traits<jtype>::jni_type type_traits<jtype>::call_static_methoda(JNIEnv* env, jclass cls, jmethodID id, const jvalue* args) { return env->CallStatic##cap_name##MethodA(cls, id, args); } \
 	type_traits<jtype>::jni_type* type_traits<jtype>::get_array_elements(JNIEnv* env, array_type arr, jboolean* copy) { return env->Get##cap_name##ArrayElements(arr, copy); } \
 	void type_traits<jtype>::release_array_elements(JNIEnv* env, array_type arr, jni_type* ptr, jint mode) { return env->Release##cap_name##ArrayElements(arr, ptr, mode); } \
+	void type_traits<jtype>::get_array_region(JNIEnv* env, array_type arr, jsize start, jsize len, jni_type* buf) { env->Get##cap_name##ArrayRegion(arr, start, len, buf); } \
+	void type_traits<jtype>::set_array_region(JNIEnv* env, array_type arr, jsize start, jsize len, const jni_type* buf) { env->Set##cap_name##ArrayRegion(arr, start, len, buf); } \
 	type_traits<jtype>::jni_type type_traits<jtype>::get_field(JNIEnv* env, jobject obj, jfieldID id) { return env->Get##cap_name##Field(obj, id); } \
 	type_traits<jtype>::jni_type type_traits<jtype>::get_static_field(JNIEnv* env, jclass obj, jfieldID id) { return env->GetStatic##cap_name##Field(obj, id); } \
+	void type_traits<jtype>::set_field(JNIEnv* env, jobject obj, jfieldID id, jtype v) { env->Set##cap_name##Field(obj, id, v); } \
+	void type_traits<jtype>::set_static_field(JNIEnv* env, jclass obj, jfieldID id, jtype v) { env->SetStatic##cap_name##Field(obj, id, v); } \
 	type_traits<jtype>::array_type type_traits<jtype>::new_array(JNIEnv* env, size_t size) { return env->New##cap_name##Array(size); }
 
 		def_primitive_type_traits(jboolean, Boolean)
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "java\signature.h"
+#include "java\object.h"
+#include "java\clazz.h"
+#include <utility>
+
+namespace java
+{
+    namespace internal
+    {
+        // Converts a C++ argument to the jvalue passed for a parameter of 
+        // the given JNI type.
+        template <typename jtype, jni::value_type = jni::descriptor<jtype>::value>
+        struct typed_arg
+        {
+            static jvalue make(typename jni::descriptor<jtype>::jni_type v) { return jni::type_traits<jtype>::to_jvalue(v); }
+        };
+
+        template <typename jtype>
+        struct typed_arg<jtype, jni::jobject_value>
+        {
+            static jvalue make(jobject v) { jvalue ret; ret.l = v; return ret; }
+            static jvalue make(const object& v) { jvalue ret; ret.l = v.native(); return ret; }
+
+            // A temporary java.lang.String would be released before the 
+            // call is made, so strings must be passed as objects.
+            static jvalue make(const char*) = delete;
+        };
+
+        // Calls a method through the JNI function matching the return type,
+        // and converts the result.  Reference types are returned as 
+        // java::object, so that the local reference is managed.
+        template <typename jtype, jni::value_type = jni::descriptor<jtype>::value>
+        struct typed_result
+        {
+            typedef jtype type;
+
+            static type call(jobject obj, jmethodID id, const jvalue* args) { return jni::call_methoda<jtype>(obj, id, args); }
+            static type call_static(jclass cls, jmethodID id, const jvalue* args) { return jni::call_static_methoda<jtype>(cls, id, args); }
+        };
+
+        template <typename jtype>
+        struct typed_result<jtype, jni::jobject_value>
+        {
+            typedef object type;
+
+            static type call(jobject obj, jmethodID id, const jvalue* args) { return object(jni::call_methoda<jobject>(obj, id, args)); }
+            static type call_static(jclass cls, jmethodID id, const jvalue* args) { return object(jni::call_static_methoda<jobject>(cls, id, args)); }
+        };
+
+        template <>
+        struct typed_result<void, jni::void_value>
+        {
+            typedef void type;
+
+            static type call(jobject obj, jmethodID id, const jvalue* args) { jni::call_methoda<void>(obj, id, args); }
+            static type call_static(jclass cls, jmethodID id, const jvalue* args) { jni::call_static_methoda<void>(cls, id, args); }
+        };
+
+        template <typename sig>
+        struct typed_call;
+
+        template <typename ret, typename... params>
+        struct typed_call<ret(params...)>
+        {
+            typedef typename typed_result<ret>::type result_type;
+
+            template <typename... ts>
+            static result_type call(jobject obj, const char* name, ts&&... args)
+            {
+                static_assert(sizeof...(ts) == sizeof...(params), "Wrong number of arguments for the method signature");
+                if (obj == nullptr) throw std::exception("Method called on a null reference");
+
+                static member_site site;
+                auto id = get_member_cache().get_method(site, obj, instance_method, name, jni::signature<ret(params...)>::value);
+                jvalue values[sizeof...(params) + 1] = { typed_arg<params>::make(std::forward<ts>(args))... };
+                return typed_result<ret>::call(obj, id, values);
+            }
+
+            template <typename... ts>
+            static result_type call_static(jclass cls, const char* name, ts&&... args)
+            {
+                static_assert(sizeof...(ts) == sizeof...(params), "Wrong number of arguments for the method signature");
+
+                static member_site site;
+                auto id = get_member_cache().get_method(site, cls, static_method, name, jni::signature<ret(params...)>::value);
+                jvalue values[sizeof...(params) + 1] = { typed_arg<params>::make(std::forward<ts>(args))... };
+                return typed_result<ret>::call_static(cls, id, values);
+            }
+        };
+    }
+
+    // These functions call a Java method whose exact signature is known at 
+    // compile time, given as a function type built from JNI types, e.g.,
+    //
+    //     jlong n = java::call<jlong(jint, jstring)>(obj, "parse", 10, str);
+    //
+    // The JNI descriptor is generated by the compiler, and the method ID is
+    // resolved with a single GetMethodID the first time a given name and 
+    // signature are called on a class.  Each signature also keeps a small
+    // memo, shared by all calls with that signature, of the names and 
+    // classes it has been called with, so a repeat call is a string 
+    // compare and a class check (IsInstanceOf, or a pointer compare for 
+    // static calls) plus the Call<Type>MethodA function for the return 
+    // type.  The name may be any string, not only a literal.  
+    // Unlike object::call and clazz::call_static, no reflection is used and
+    // no overload resolution is performed.  Reference results are returned
+    // as java::object.
+    template <typename sig, typename... ts>
+    typename internal::typed_call<sig>::result_type call(const object& obj, const char* name, ts&&... args)
+    {
+        return internal::typed_call<sig>::call(obj.native(), name, std::forward<ts>(args)...);
+    }
+
+    template <typename sig, typename... ts>
+    typename internal::typed_call<sig>::result_type call_static(const clazz& cls, const char* name, ts&&... args)
+    {
+        return internal::typed_call<sig>::call_static(cls.native(), name, std::forward<ts>(args)...);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "jni.h"
+#include <cstddef>
+
+namespace java
+{
+    namespace utf
+    {
+        // These functions convert between standard UTF-8 and the UTF-16 used
+        // by Java strings.  The JNI's own *StringUTF* functions use modified
+        // UTF-8, which encodes NUL as two bytes and supplementary characters
+        // as two three-byte surrogates, so text they produce isn't valid
+        // UTF-8 and they can't read UTF-8 that contains four-byte sequences.
+        //
+        // Runs of ASCII, which is the common case for identifiers, keys and
+        // log lines, are converted 16 characters at a time with SSE2 where
+        // it is available.  Everything else goes through a scalar loop.
+        // Malformed input (invalid UTF-8, unpaired surrogates) is replaced
+        // with U+FFFD rather than rejected.
+
+        // The largest number of UTF-16 code units a UTF-8 string of len
+        // bytes can convert to.
+        inline size_t max_utf16_length(size_t len) { return len; }
+
+        // The largest number of bytes a UTF-16 string of len code units can
+        // convert to.
+        inline size_t max_utf8_length(size_t len) { return len * 3; }
+
+        // Converts len bytes of UTF-8 into dst, which must hold at least
+        // max_utf16_length(len) code units.  Returns the number of code
+        // units written.
+        size_t utf8_to_utf16(const char* src, size_t len, jchar* dst);
+
+        // Converts len UTF-16 code units into dst, which must hold at least
+        // max_utf8_length(len) bytes.  Returns the number of bytes written.
+        size_t utf16_to_utf8(const jchar* src, size_t len, char* dst);
+    }
+}
@@ -0,0 +1,196 @@
+
+#include "utf.h"
+
+#if !defined(JAVA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JAVA_UTF_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace java
+{
+    namespace utf
+    {
+#ifdef JAVA_UTF_SSE2
+        namespace
+        {
+            // Returns the index of the lowest set bit of a non-zero mask.
+            inline unsigned first_set_bit(unsigned mask)
+            {
+#ifdef _MSC_VER
+                unsigned long index;
+                _BitScanForward(&index, mask);
+                return (unsigned)index;
+#else
+                return (unsigned)__builtin_ctz(mask);
+#endif
+            }
+        }
+#endif
+
+        size_t utf8_to_utf16(const char* src, size_t len, jchar* dst)
+        {
+            auto s = reinterpret_cast<const unsigned char*>(src);
+            auto end = s + len;
+            jchar* out = dst;
+
+            while (s < end)
+            {
+                unsigned c = *s;
+                if (c < 0x80)
+                {
+#ifdef JAVA_UTF_SSE2
+                    // Widen 16 ASCII bytes at a time by interleaving them
+                    // with zeros.  When a block has a non-ASCII byte, only
+                    // the characters before it are kept, and the scalar code
+                    // picks up at that byte.  The output never runs ahead 
+                    // of the input, so the whole block can be stored.
+                    const __m128i zero = _mm_setzero_si128();
+                    while (end - s >= 16)
+                    {
+                        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+                        unsigned non_ascii = (unsigned)_mm_movemask_epi8(bytes);
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(bytes, zero));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpackhi_epi8(bytes, zero));
+                        if (non_ascii != 0)
+                        {
+                            unsigned ascii = first_set_bit(non_ascii);
+                            s += ascii;
+                            out += ascii;
+                            break;
+                        }
+                        s += 16;
+                        out += 16;
+                    }
+                    if (s == end) break;
+                    c = *s;
+                    if (c >= 0x80) continue;
+#endif
+                    *out++ = (jchar)c;
+                    s++;
+                    continue;
+                }
+
+                size_t n;
+                unsigned cp, min;
+                if ((c & 0xE0) == 0xC0) { n = 2; cp = c & 0x1F; min = 0x80; }
+                else if ((c & 0xF0) == 0xE0) { n = 3; cp = c & 0x0F; min = 0x800; }
+                else if ((c & 0xF8) == 0xF0) { n = 4; cp = c & 0x07; min = 0x10000; }
+                else
+                {
+                    *out++ = 0xFFFD;
+                    s++;
+                    continue;
+                }
+
+                size_t i = 1;
+                while (i < n && s + i < end && (s[i] & 0xC0) == 0x80)
+                {
+                    cp = (cp << 6) | (s[i] & 0x3F);
+                    i++;
+                }
+
+                // Truncated, overlong and out of range sequences, and
+                // encoded surrogates, become a single replacement character.
+                if (i < n || cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+                {
+                    *out++ = 0xFFFD;
+                    s += i;
+                    continue;
+                }
+
+                s += n;
+                if (cp >= 0x10000)
+                {
+                    cp -= 0x10000;
+                    *out++ = (jchar)(0xD800 + (cp >> 10));
+                    *out++ = (jchar)(0xDC00 + (cp & 0x3FF));
+                }
+                else
+                {
+                    *out++ = (jchar)cp;
+                }
+            }
+
+            return out - dst;
+        }
+
+        size_t utf16_to_utf8(const jchar* src, size_t len, char* dst)
+        {
+            auto s = src;
+            auto end = s + len;
+            auto out = reinterpret_cast<unsigned char*>(dst);
+
+            while (s < end)
+            {
+                unsigned c = *s;
+                if (c < 0x80)
+                {
+#ifdef JAVA_UTF_SSE2
+                    // Narrow 16 ASCII characters at a time.  The check masks
+                    // off the low seven bits of every character; each one
+                    // that is left sets two bits of the mask.  As above, a
+                    // block with a non-ASCII character is stored whole (the
+                    // saturated bytes past the ASCII run are overwritten 
+                    // later), and the scalar code resumes at that character.
+                    const __m128i zero = _mm_setzero_si128();
+                    const __m128i high_bits = _mm_set1_epi16((short)0xFF80);
+                    while (end - s >= 16)
+                    {
+                        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+                        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 8));
+                        unsigned ascii_lo = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(lo, high_bits), zero));
+                        unsigned ascii_hi = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(hi, high_bits), zero));
+                        unsigned non_ascii = ~(ascii_lo | (ascii_hi << 16));
+                        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+                        if (non_ascii != 0)
+                        {
+                            unsigned ascii = first_set_bit(non_ascii) / 2;
+                            s += ascii;
+                            out += ascii;
+                            break;
+                        }
+                        s += 16;
+                        out += 16;
+                    }
+                    if (s == end) break;
+                    c = *s;
+                    if (c >= 0x80) continue;
+#endif
+                    *out++ = (unsigned char)c;
+                    s++;
+                    continue;
+                }
+
+                if (c < 0x800)
+                {
+                    *out++ = (unsigned char)(0xC0 | (c >> 6));
+                    *out++ = (unsigned char)(0x80 | (c & 0x3F));
+                    s++;
+                }
+                else if (c >= 0xD800 && c <= 0xDBFF && end - s >= 2 && s[1] >= 0xDC00 && s[1] <= 0xDFFF)
+                {
+                    unsigned cp = 0x10000 + ((c - 0xD800) << 10) + (s[1] - 0xDC00);
+                    *out++ = (unsigned char)(0xF0 | (cp >> 18));
+                    *out++ = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+                    *out++ = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+                    *out++ = (unsigned char)(0x80 | (cp & 0x3F));
+                    s += 2;
+                }
+                else
+                {
+                    // An unpaired surrogate can't be represented in UTF-8.
+                    if (c >= 0xD800 && c <= 0xDFFF) c = 0xFFFD;
+                    *out++ = (unsigned char)(0xE0 | (c >> 12));
+                    *out++ = (unsigned char)(0x80 | ((c >> 6) & 0x3F));
+                    *out++ = (unsigned char)(0x80 | (c & 0x3F));
+                    s++;
+                }
+            }
+
+            return out - reinterpret_cast<unsigned char*>(dst);
+        }
+    }
+}